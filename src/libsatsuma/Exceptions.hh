@@ -21,6 +21,11 @@ class UnboundedError : public Exception {
     using Exception::Exception;
 };
 
+/// Costs cannot be represented by the integer costs of a solver
+class CostOverflowError : public Exception {
+    using Exception::Exception;
+};
+
 /// Satsuma bug
 class InternalError : public Exception {
     using Exception::Exception;
@@ -2,18 +2,26 @@
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Extra/Highlevel.hh>
 
+#include <libsatsuma/Problems/CostTable.hh>
 #include <libsatsuma/Solvers/EvenBiMDF.hh>
 #include <libsatsuma/Solvers/BiMDFRefinement.hh>
+#include <libsatsuma/Solvers/BiMDFCycleCanceling.hh>
+#include <libsatsuma/Solvers/BiMDFLocalSearch.hh>
+#include <libsatsuma/Solvers/BiMDFUnicyclic.hh>
 #include <libsatsuma/Reductions/BiMDF_to_BiMCF.hh>
 #include <libsatsuma/Reductions/BiMCF_to_MCF.hh>
 #include <libsatsuma/Reductions/BiMCF_to_BMatching.hh>
 #include <libsatsuma/Reductions/BMatching_to_Matching.hh>
 #include <libsatsuma/Reductions/BiMDF_Simplification.hh>
+#include <libsatsuma/Reductions/BiMDF_Presolve.hh>
 #include <libsatsuma/Solvers/Matching.hh>
 #include <libsatsuma/Solvers/MCF.hh>
 #include <libsatsuma/Exceptions.hh>
+#include <libsatsuma/Extra/Parallel.hh>
 
 #include "lemon/maps.h"
+#include <optional>
+#include <random>
 
 #if SATSUMA_HAVE_GUROBI
 #  include <libsatsuma/Solvers/BiMCFGurobi.hh> // just for testing
@@ -46,7 +54,8 @@ BiMDFMatchingResult solve_bimdf_matching(const BiMDF &bimdf, const BiMDFSolverCo
         std::cout << "DC approx: cost = " << bimdf.cost(*dc_sol.solution)
                   << ", max dev " << dc_sol.info.max_deviation_solution << std::endl;
     }
-    if (!_config.refine_with_matching) {
+    if (!_config.refine_with_matching
+            && _config.refinement_method != RefinementMethod::LocalSearch) {
         auto cost = dc_sol.info.cost; // need to copy before moving dc_sol.info out
         return {.result = {
                 .solution = std::move(dc_sol.solution),
@@ -56,6 +65,7 @@ BiMDFMatchingResult solve_bimdf_matching(const BiMDF &bimdf, const BiMDFSolverCo
                 .cost = cost,
                 .cost_changes = {},
                 .max_refinement_change = 0,
+                .max_deviation = 0,
             },
             .stopwatch = std::move(dc_sol.stopwatch)};
     }
@@ -64,36 +74,194 @@ BiMDFMatchingResult solve_bimdf_matching(const BiMDF &bimdf, const BiMDFSolverCo
 
     std::vector<double> cost_changes;
 
-    for (int maxdev = _config.refinement_maxdev_min; maxdev <= _config.refinement_maxdev_max; ++maxdev) {
+    int maxdev_min = _config.refinement_maxdev_min;
+    int maxdev_max = _config.refinement_maxdev_max;
+    if (_config.refinement_memory_budget > 0) {
+        while (maxdev_max > 1
+               && estimate_refinement_memory(bimdf, maxdev_max) > _config.refinement_memory_budget)
+        {
+            --maxdev_max;
+        }
+        if (_config.verbosity >= 2 && maxdev_max < _config.refinement_maxdev_max) {
+            std::cout << "refinement: memory budget limits max deviation to "
+                      << maxdev_max << std::endl;
+        }
+    }
+    if (_config.refinement_adaptive_maxdev
+            && bimdf.n_edges() > _config.refinement_adaptive_large_edges)
+    {
+        maxdev_min = 1;
+    }
+    maxdev_min = std::min(maxdev_min, maxdev_max);
+
+    if (_config.refinement_method == RefinementMethod::CycleCanceling) {
+        sw_refinement.resume();
+        auto res = refine_with_cycle_canceling(bimdf, *sol,
+                maxdev_max,
+                _config.verbosity);
+        sw_refinement.stop();
+        if (_config.verbosity >= 1) {
+            std::cout << "cycle canceling: cost ch. " << res.cost_change << std::endl;
+        }
+        cost_changes.push_back(res.cost_change);
+        sol = std::move(res.sol);
+        // cycle canceling is not exact, confirm with matching:
+        maxdev_min = maxdev_max;
+    }
+
+    if (_config.refinement_method == RefinementMethod::LocalSearch) {
+        sw_refinement.resume();
+        auto res = refine_with_local_search(bimdf, *sol, _config.local_search);
+        sw_refinement.stop();
+        if (_config.verbosity >= 1) {
+            std::cout << "local search: cost ch. " << res.cost_change << std::endl;
+        }
+        cost_changes.push_back(res.cost_change);
+        sol = std::move(res.sol);
+        if (!_config.refine_with_matching) {
+            // preview quality: skip all matching passes below
+            maxdev_max = 0;
+        }
+    }
+
+    // warm start for optimality certificates
+    std::vector<MCF::CostScalar> potential = std::move(dc_sol.potential);
+    const double potential_multiplier = dc_sol.potential_multiplier;
+
+    if (_config.refinement_fixing_threshold > 0 && maxdev_max > 0) {
+        if (_config.verbosity >= 1) {
+            std::cout << "reduced-cost fixing: cost ch. " << std::flush;
+        }
+        while (true) {
+            sw_refinement.resume();
+            auto active = reduced_cost_candidates(bimdf, *sol, potential, potential_multiplier,
+                                                  _config.refinement_fixing_threshold);
+            auto res = refine_with_matching_restricted(bimdf, *sol, *active,
+                    maxdev_max,
+                    _config.deviation_limit,
+                    _config.matching_solver);
+            sw_refinement.stop();
+            if (_config.verbosity >= 1) {
+                std::cout << "R" << res.cost_change << " " << std::flush;
+            }
+            cost_changes.push_back(res.cost_change);
+            if (res.cost_change > -1e-20) {
+                break;
+            }
+            sol = std::move(res.sol);
+        }
+        if (_config.verbosity >= 1) {
+            std::cout << std::endl;
+        }
+    }
+    for (int maxdev = maxdev_min; maxdev <= maxdev_max; ++maxdev) {
         if (_config.verbosity >= 1) {
             std::cout << "refinement max deviation = " << maxdev << ": cost ch. " << std::flush;
         }
+        const size_t level_begin = cost_changes.size();
+        if (_config.refinement_region_edges > 0
+                && bimdf.n_edges() > 2 * _config.refinement_region_edges)
+        {
+            const size_t n_regions = (bimdf.n_edges() + _config.refinement_region_edges - 1)
+                                     / _config.refinement_region_edges;
+            std::mt19937 rng(maxdev); // deterministic choice of region seeds
+            std::uniform_int_distribution<int> node_dist(0, bimdf.g.maxNodeId());
+            while (true) {
+                sw_refinement.resume();
+                auto regions = bfs_edge_regions(bimdf, n_regions,
+                                                bimdf.g.nodeFromId(node_dist(rng)));
+                auto res = refine_regions_with_matching(bimdf, *sol, regions, maxdev,
+                        _config.deviation_limit,
+                        _config.matching_solver,
+                        _config.refinement_threads);
+                sw_refinement.stop();
+                if (_config.verbosity >= 1)
+                {
+                    std::cout << "P" << res.cost_change << " " << std::flush;
+                }
+                cost_changes.push_back(res.cost_change);
+                if (res.cost_change > -1e-20) {
+                    break;
+                }
+                sol = std::move(res.sol);
+            }
+        }
+        std::unique_ptr<BiMDF::EdgeMap<bool>> frontier;
+        bool windowed = _config.refinement_window_pin_cost > 0;
         while(true) {
+            if (!frontier && _config.refinement_certificate) {
+                sw_refinement.resume();
+                bool optimal = refinement_certificate(bimdf, *sol, maxdev, potential);
+                sw_refinement.stop();
+                if (optimal) {
+                    if (_config.verbosity >= 1) {
+                        std::cout << "C " << std::flush;
+                    }
+                    break;
+                }
+            }
             sw_refinement.resume();
-            auto res = refine_with_matching(bimdf, *sol, maxdev,
+            std::unique_ptr<BiMDF::EdgeMap<int>> windows;
+            if (!frontier && windowed) {
+                windows = deviation_windows(bimdf, *sol, maxdev,
+                                            _config.refinement_window_pin_cost);
+            }
+            auto res = frontier
+                ? refine_with_matching_restricted(bimdf, *sol, *frontier, maxdev,
                     _config.deviation_limit,
-                    _config.matching_solver);
+                    _config.matching_solver)
+                : refine_with_matching(bimdf, *sol, maxdev,
+                    _config.deviation_limit,
+                    _config.matching_solver,
+                    windows.get());
             sw_refinement.stop();
 
             if (_config.verbosity >= 1)
             {
-                std::cout << res.cost_change << " " << std::flush;
+                std::cout << (frontier ? "L" : windows ? "W" : "")
+                          << res.cost_change << " " << std::flush;
             }
 
             cost_changes.push_back(res.cost_change);
-            if (res.cost_change > -1e-20) // TODO: use integer costs
+            if (res.cost_change > -1e-20) { // TODO: use integer costs
+                if (frontier) {
+                    // no local improvement, confirm with a global pass
+                    frontier.reset();
+                    continue;
+                }
+                if (windows) {
+                    // no improvement within the windows, confirm with the full window
+                    windowed = false;
+                    continue;
+                }
                 break;
+            }
+            if (_config.refinement_frontier_hops > 0) {
+                sw_refinement.resume();
+                frontier = refinement_frontier(bimdf, *sol, *res.sol,
+                                               _config.refinement_frontier_hops);
+                sw_refinement.stop();
+            }
             sol = std::move(res.sol);
         }
         if (_config.verbosity >= 1) {
             std::cout << std::endl;
         }
+        if (_config.refinement_adaptive_maxdev) {
+            double level_change = 0;
+            for (size_t i = level_begin; i < cost_changes.size(); ++i) {
+                level_change += cost_changes[i];
+            }
+            if (level_change > -1e-20) {
+                break; // no improvement on this level, do not escalate
+            }
+        }
     }
     sw_root.stop();
 
-    int max_change = 0;
+    BiMDF::FlowScalar max_change = 0;
     for (const auto e: bimdf.g.edges()) {
-        max_change = std::max(max_change, std::abs((*sol)[e] - (*dc_sol.solution)[e]));
+        max_change = std::max<BiMDF::FlowScalar>(max_change, std::abs((*sol)[e] - (*dc_sol.solution)[e]));
     }
     if (_config.verbosity > 2)
     {
@@ -116,76 +284,123 @@ BiMDFMatchingResult solve_bimdf_matching(const BiMDF &bimdf, const BiMDFSolverCo
                 .cost = cost,
                 .cost_changes = std::move(cost_changes),
                 .max_refinement_change = max_change,
+                .max_deviation = maxdev_max,
             },
             .stopwatch = sw_result};
 }
 
-BiMDFFullResult solve_bimdf(const BiMDF &_bimdf, const BiMDFSolverConfig &_config)
+static BiMDFFullResult solve_bimdf_components(const BiMDF &_bimdf, const BiMDFSolverConfig &_config)
 {
     Timekeeper::HierarchicalStopWatch sw("solve_bimdf");
     Timekeeper::HierarchicalStopWatch sw_cc("cc", sw);
     Timekeeper::HierarchicalStopWatch sw_simp("simplification", sw);
+    Timekeeper::HierarchicalStopWatch sw_low_cyclomatic("low cyclomatic", sw);
     sw.resume();
 
     sw_cc.resume();
-    Satsuma::BiMDF_ConnectedComponents cc(_bimdf);
+    Satsuma::BiMDF_ConnectedComponents cc(_bimdf, {
+            .pack_below_edges = _config.pack_components_below_edges,
+            // keep trees and single cycles separate for the fast path
+            .pack_low_cyclomatic = !_config.low_cyclomatic_fast_path,
+            .deduplicate = _config.deduplicate_components,
+            .threads = _config.component_threads,
+            .verbosity = _config.verbosity});
     sw_cc.stop();
-    size_t n_cc = cc.bimdfs().size();
-
-    std::vector<BiMDFResult> sols;
-    std::vector<Timekeeper::HierarchicalStopWatchResult> sw_results;
-    std::vector<BiMDFperConnectedComponentInfo> cc_info;
-
-    sols.reserve(n_cc);
-    sw_results.reserve(n_cc);
-    cc_info.reserve(n_cc);
-
-    // TODO: parallel solve? are both matching solvers sufficiently thread-safe? is it worth the overhead?
-    for (const auto &sub_bimdf: cc.bimdfs()) {
-        sw_simp.resume();
-#if 1
-        Satsuma::BiMDF_Simplification simp(sub_bimdf);
-        sw_simp.stop();
-        auto simp_sol = Satsuma::solve_bimdf_matching(simp.bimdf(), _config);
-        sw_results.push_back(std::move(simp_sol.stopwatch));
-        cc_info.push_back({
+    size_t n_cc = cc.size();
+
+    std::vector<BiMDFResult> sols(n_cc);
+    std::vector<std::optional<Timekeeper::HierarchicalStopWatchResult>> sw_results(n_cc);
+    std::vector<BiMDFperConnectedComponentInfo> cc_info(n_cc);
+
+    std::vector<size_t> to_solve;
+    for (size_t cc_idx = 0; cc_idx < n_cc; ++cc_idx) {
+        if (cc.representative(cc_idx) == cc_idx) {
+            to_solve.push_back(cc_idx);
+        }
+    }
+    // Sub-problems are either solved in parallel, or one after the other with
+    // parallel preprocessing. Only the sequential mode times the individual steps.
+    const bool sequential = _config.component_threads == 1 || to_solve.size() <= 1;
+    const unsigned simp_threads = to_solve.size() <= 1 ? _config.component_threads : 1;
+    // parallel component solves already use the threads, avoid oversubscription
+    BiMDFSolverConfig sub_config = _config;
+    if (!sequential) {
+        sub_config.refinement_threads = 1;
+        // logs of concurrent solves would interleave
+        sub_config.verbosity = 0;
+        sub_config.double_cover.verbosity = 0;
+    }
+    auto timed = [sequential](Timekeeper::HierarchicalStopWatch &_sw, auto &&_f) {
+        if (sequential) _sw.resume();
+        _f();
+        if (sequential) _sw.stop();
+    };
+
+    auto solve_one = [&](size_t cc_idx) {
+        const auto &sub_bimdf = cc.bimdf(cc_idx);
+        if (_config.low_cyclomatic_fast_path
+                && cc.n_components(cc_idx) == 1
+                && bimdf_cyclomatic_number(sub_bimdf) <= 1) {
+            // trees and single cycles: no DC or matching needed
+            timed(sw_low_cyclomatic, [&]{sols[cc_idx] = solve_bimdf_unicyclic(sub_bimdf);});
+            cc_info[cc_idx] = {
+                              .n_nodes = sub_bimdf.n_nodes(),
+                              .n_edges = sub_bimdf.n_edges(),
+                              .double_cover = {},
+                              .matching = {.cost = sols[cc_idx].cost,
+                                           .cost_changes = {},
+                                           .max_refinement_change = 0,
+                                           .max_deviation = 0}};
+            return;
+        }
+        std::optional<Satsuma::BiMDF_Simplification> simp;
+        timed(sw_simp, [&]{simp.emplace(sub_bimdf, sub_config.verbosity, simp_threads);});
+        // the simplified problem belongs to this solve, so it may hold the table
+        CostTable::Scope cost_table{simp->bimdf(), _config.cost_table_radius};
+        auto simp_sol = Satsuma::solve_bimdf_matching(simp->bimdf(), sub_config);
+        sw_results[cc_idx] = std::move(simp_sol.stopwatch);
+        cc_info[cc_idx] = {
                               .n_nodes = sub_bimdf.n_nodes(),
                               .n_edges = sub_bimdf.n_edges(),
                               .double_cover = std::move(simp_sol.double_cover_info),
-                              .matching = std::move(simp_sol.info)});
-        if (_config.verbosity >= 3) {
-            std::cout << "\tsimp. sub-BiMDF, cost = " << simp.bimdf().cost(*simp_sol.result.solution) << std::endl;
-        }
-        sw_simp.resume();
-        auto bimdf_result = simp.translate_solution(simp_sol.result);
-        sw_simp.stop();
-#else
-        auto bimdf_result = Satsuma::solve_bimdf_matching(sub_bimdf).result;
-#endif
-
-        //auto bimdf_sol = Satsuma::solve_bimdf_matching(sub_bimdf, 2, 2, Satsuma::MatchingSolver::BlossomV, 5);
-        //std::cout << "full solved sub- BiMDF, cost = " << sub_bimdf.cost(*bimdf_sol.solution) << std::endl;
-        sols.push_back(std::move(bimdf_result));
-        // TODO: collect information from sub-solves
-    }
+                              .matching = std::move(simp_sol.info)};
+        if (sub_config.verbosity >= 3) {
+            std::cout << "\tsimp. sub-BiMDF, cost = " << simp->bimdf().cost(*simp_sol.result.solution) << std::endl;
+        }
+        timed(sw_simp, [&]{sols[cc_idx] = simp->translate_solution(simp_sol.result);});
+    };
+    parallel_for(to_solve.size(), sequential ? 1 : _config.component_threads,
+                 [&](size_t i) {solve_one(to_solve[i]);});
 
     sw_cc.resume();
+    for (size_t cc_idx = 0; cc_idx < n_cc; ++cc_idx) {
+        if (auto rep = cc.representative(cc_idx); rep != cc_idx) {
+            const auto &sub_bimdf = cc.bimdf(cc_idx);
+            sols[cc_idx] = cc.map_solution(cc_idx, sols[rep]);
+            cc_info[cc_idx] = {
+                              .n_nodes = sub_bimdf.n_nodes(),
+                              .n_edges = sub_bimdf.n_edges(),
+                              .double_cover = {},
+                              .matching = {.cost = sols[cc_idx].cost,
+                                           .cost_changes = {},
+                                           .max_refinement_change = 0,
+                                           .max_deviation = 0}};
+        }
+    }
     auto bimdf_sol = cc.translate_solutions(sols);
     sw_cc.stop();
 
-    if (_config.verbosity >= 1) {
-        std::cout << "Solved BiMDF, cost = " << _bimdf.cost(*bimdf_sol.solution) << std::endl;
-    }
-
-
     sw.stop();
     auto sw_result = Timekeeper::HierarchicalStopWatchResult(sw);
     size_t sub_id = 0;
     for (auto &sub_sw: sw_results) {
+        if (!sub_sw) {
+            continue;
+        }
         // avoid spurious(?) -Wrestrict warning that occurs with `+=` by using tmp:
-        auto tmp = sub_sw.name + std::string(" ") + std::to_string(sub_id++);
-        sub_sw.name = tmp;
-        sw_result.add_child(sub_sw);
+        auto tmp = sub_sw->name + std::string(" ") + std::to_string(sub_id++);
+        sub_sw->name = tmp;
+        sw_result.add_child(*sub_sw);
     }
 
     return {.solution = std::move(bimdf_sol.solution),
@@ -195,4 +410,35 @@ BiMDFFullResult solve_bimdf(const BiMDF &_bimdf, const BiMDFSolverConfig &_confi
 
 }
 
+BiMDFFullResult solve_bimdf(const BiMDF &_bimdf, const BiMDFSolverConfig &_config)
+{
+    auto result = [&]() -> BiMDFFullResult {
+        if (!_config.presolve) {
+            return solve_bimdf_components(_bimdf, _config);
+        }
+        Timekeeper::HierarchicalStopWatch sw("solve_bimdf (presolved)");
+        Timekeeper::HierarchicalStopWatch sw_presolve("presolve", sw);
+        sw.resume();
+        sw_presolve.resume();
+        BiMDF_Presolve presolve(_bimdf, {.verbosity = _config.verbosity});
+        sw_presolve.stop();
+        auto res = solve_bimdf_components(presolve.bimdf(), _config);
+        sw_presolve.resume();
+        auto orig_res = presolve.translate_solution({.solution = std::move(res.solution),
+                                                     .cost = res.cost});
+        sw_presolve.stop();
+        sw.stop();
+        auto sw_result = Timekeeper::HierarchicalStopWatchResult(sw);
+        sw_result.add_child(res.stopwatch);
+        return {.solution = std::move(orig_res.solution),
+                .cost = orig_res.cost,
+                .cc_info = std::move(res.cc_info),
+                .stopwatch = std::move(sw_result)};
+    }();
+    if (_config.verbosity >= 1) {
+        std::cout << "Solved BiMDF, cost = " << _bimdf.cost(*result.solution) << std::endl;
+    }
+    return result;
+}
+
 } // namespace Satsuma
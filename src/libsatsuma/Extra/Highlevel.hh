@@ -9,6 +9,7 @@
 #include <libsatsuma/Reductions/BiMDF_to_BiMCF.hh>
 #include <libsatsuma/Reductions/BiMCF_to_MCF.hh>
 #include <libsatsuma/Reductions/BiMCF_to_BMatching.hh>
+#include <libsatsuma/Solvers/BiMDFLocalSearch.hh>
 #include <libsatsuma/Config/Export.hh>
 #if SATSUMA_HAVE_GUROBI
 #include <libsatsuma/Config/Gurobi.hh>
@@ -20,7 +21,10 @@ namespace Satsuma {
 struct BiMDFMatchingInfo {
     BiMDF::CostScalar cost;
     std::vector<double> cost_changes;
-    int max_refinement_change;
+    BiMDF::FlowScalar max_refinement_change;
+    /// Maximum deviation of the last refinement level, i.e. refinement_maxdev_max
+    /// after applying refinement_memory_budget; 0 if no matching passes were run.
+    int max_deviation;
 };
 
 struct BiMDFMatchingResult {
@@ -30,18 +34,91 @@ struct BiMDFMatchingResult {
     Timekeeper::HierarchicalStopWatchResult stopwatch;
 };
 
+enum class RefinementMethod {
+    /// Solve a perfect matching problem around the current solution in every pass.
+    Matching,
+    /// Cancel negative cycles in the residual graph, then confirm optimality
+    /// with a single matching pass at refinement_maxdev_max.
+    CycleCanceling,
+    /// Greedy local search over short cycles (see refine_with_local_search) first.
+    /// With refine_with_matching = false, no matching passes follow:
+    /// fast, preview-quality results without optimality guarantee.
+    LocalSearch,
+    Default = Matching
+};
+
 struct BiMDFSolverConfig {
     BiMDFDoubleCoverConfig double_cover;
     /// matching solver to use for refinement (can theoretically be different from solver used for DC)
     MatchingSolver matching_solver = MatchingSolver::Default;
 
+    /// Refine the DC approximation with matching passes; if false, the DC result
+    /// is returned as is (or after local search, see RefinementMethod::LocalSearch).
     bool refine_with_matching = true;
+    RefinementMethod refinement_method = RefinementMethod::Default;
+    BiMDFLocalSearchConfig local_search;
     /// Maximum deviation from x0 in primary iterations.
     /// 1 or 2 are recommended.
     int refinement_maxdev_min = 2;
     /// Maximum deviation from x0 in last iteration.
     /// Note: 2 always suffices for an exact solution.
     int refinement_maxdev_max = 2;
+    /// If > 0, refinement passes after the first one only consider edges within this
+    /// many hops of the edges changed by the previous pass. A global pass
+    /// confirms optimality once a localized pass finds no improvement.
+    int refinement_frontier_hops = 0;
+    /// If > 0, components with more than twice this many edges are first refined
+    /// in regions of about this many edges that are solved in parallel with
+    /// all other flows fixed. The regions change between rounds so their
+    /// boundaries move; global passes confirm optimality.
+    size_t refinement_region_edges = 0;
+    /// Number of threads for region refinement, 0: use all hardware threads.
+    unsigned refinement_threads = 0;
+    /// Before each global refinement pass, check if a cheap optimality certificate
+    /// (double cover potentials) shows that the pass can not improve the solution,
+    /// and skip it in that case. Mostly saves the final, confirming pass.
+    bool refinement_certificate = true;
+    /// If > 0, start refinement with passes restricted to edges that have a unit
+    /// move with reduced cost below this threshold (w.r.t. the double cover potentials).
+    /// Shrinks the first matching problems; unrestricted passes follow, so the result is unaffected.
+    BiMDF::CostScalar refinement_fixing_threshold = 0;
+    /// If > 0, global refinement passes use per-edge deviation windows (see deviation_windows)
+    /// with this pinning cost until they find no improvement, then a pass with
+    /// the full window confirms the result.
+    BiMDF::CostScalar refinement_window_pin_cost = 0;
+    /// Adaptive maxdev schedule: after the first level, escalate to the next maxdev only
+    /// if the previous level improved the cost. Components with more than
+    /// refinement_adaptive_large_edges edges start at maxdev 1.
+    /// Trades the optimality guarantee of refinement_maxdev_max for speed.
+    bool refinement_adaptive_maxdev = false;
+    size_t refinement_adaptive_large_edges = 100000;
+    /// If > 0, approximate memory budget in bytes for a refinement pass:
+    /// maxdev is capped to the largest value whose estimated
+    /// matching problem (see estimate_refinement_memory) fits.
+    size_t refinement_memory_budget = 0;
+    /// Solve connected components that are trees or contain a single cycle
+    /// directly (see solve_bimdf_unicyclic) instead of via DC and matching.
+    bool low_cyclomatic_fast_path = true;
+    /// If > 0, connected components with fewer edges are packed into a single
+    /// sub-problem that is solved at once, avoiding per-component overhead
+    /// for inputs with many tiny components.
+    size_t pack_components_below_edges = 0;
+    /// Solve components that are identical up to relabeling (same demands, bounds,
+    /// head flags and cost functions) only once and reuse the solution.
+    bool deduplicate_components = false;
+    /// Run BiMDF_Presolve (fixed edges, degree-1 and forced-zero nodes,
+    /// merging of parallel edges) on the whole problem first.
+    bool presolve = false;
+    /// Threads for component labelling and simplification, and for solving
+    /// several connected components concurrently (0: all hardware threads).
+    /// Components solved concurrently use a single refinement thread each.
+    unsigned component_threads = 1;
+    /// Precompute the costs of each edge within this distance of its guess
+    /// for the double cover and refinement stages (see CostTable), 0: disabled.
+    /// Worthwhile for expensive cost functions such as VirtualObjective or long Sums.
+    /// Used by solve_bimdf on its simplified components; solve_bimdf_matching
+    /// never modifies its input, install a CostTable::Scope yourself there.
+    int cost_table_radius = 0;
     DeviationLimitKind deviation_limit = DeviationLimitKind::Default;
     int verbosity = 2;
 };
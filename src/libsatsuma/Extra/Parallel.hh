@@ -0,0 +1,66 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Satsuma {
+
+/// Call `f(i)` for all i in [0, n), distributing the calls dynamically
+/// over up to `n_threads` threads (0: use all hardware threads).
+/// The first exception thrown by any call is rethrown in the calling thread,
+/// remaining calls are skipped in that case.
+template<typename F>
+void parallel_for(size_t n, unsigned n_threads, F &&f)
+{
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    n_threads = static_cast<unsigned>(std::min<size_t>(n_threads, n));
+    if (n_threads <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            f(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        while (true) {
+            const size_t i = next++;
+            if (i >= n) {
+                return;
+            }
+            try {
+                f(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = n;
+                return;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (unsigned t = 1; t < n_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace Satsuma
@@ -31,6 +31,11 @@ NLOHMANN_JSON_SERIALIZE_ENUM(DeviationLimitKind, {
     {DeviationLimitKind::NodeThroughflow, "NodeThroughflow"},
 })
 
+NLOHMANN_JSON_SERIALIZE_ENUM(RefinementMethod, {
+    {RefinementMethod::Matching, "Matching"},
+    {RefinementMethod::CycleCanceling, "CycleCanceling"},
+    {RefinementMethod::LocalSearch, "LocalSearch"},
+})
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFDoubleCoverInfo,
                                    evening_cost,
@@ -43,7 +48,8 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFDoubleCoverInfo,
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFMatchingInfo,
                                    cost,
                                    cost_changes,
-                                   max_refinement_change);
+                                   max_refinement_change,
+                                   max_deviation);
 
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFMatchingResult,
@@ -72,12 +78,34 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFDoubleCoverConfig,
                                    verbosity,
                                    method);
 
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFLocalSearchConfig,
+                                   max_cycle_length,
+                                   max_step,
+                                   max_sweeps);
+
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(BiMDFSolverConfig,
                                    double_cover,
                                    matching_solver,
                                    refine_with_matching,
+                                   refinement_method,
+                                   local_search,
                                    refinement_maxdev_min,
                                    refinement_maxdev_max,
+                                   refinement_frontier_hops,
+                                   refinement_region_edges,
+                                   refinement_threads,
+                                   refinement_certificate,
+                                   refinement_fixing_threshold,
+                                   refinement_window_pin_cost,
+                                   refinement_adaptive_maxdev,
+                                   refinement_adaptive_large_edges,
+                                   refinement_memory_budget,
+                                   low_cyclomatic_fast_path,
+                                   pack_components_below_edges,
+                                   deduplicate_components,
+                                   presolve,
+                                   component_threads,
+                                   cost_table_radius,
                                    deviation_limit,
                                    verbosity);
 
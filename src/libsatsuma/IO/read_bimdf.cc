@@ -28,6 +28,19 @@ static CostFunction::Function read_cost(std::istream &s)
                 .target = target,
                 .weight = weight,
                 .eps = eps});
+    } else if (cost_type == 'P') {
+        size_t n_breakpoints;
+        double value;
+        s >> n_breakpoints >> value;
+        std::vector<double> breakpoints(n_breakpoints);
+        std::vector<double> slopes(n_breakpoints + 1);
+        for (auto &b: breakpoints) {
+            s >> b;
+        }
+        for (auto &slope: slopes) {
+            s >> slope;
+        }
+        return  CostFunction::PiecewiseLinear(std::move(breakpoints), std::move(slopes), value);
     } else if (cost_type == '+') {
         size_t count;
         s >> count;
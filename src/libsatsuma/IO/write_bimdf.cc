@@ -18,6 +18,15 @@ static  std::ostream& write_cost(std::ostream &s,
         s << "S " << cost_sf->target
             << " " << cost_sf->weight
             << " " << cost_sf->eps;
+    } else if (auto cost_pl = std::get_if<CostFunction::PiecewiseLinear>(&cost_func)) {
+        s << "P " << cost_pl->breakpoints().size()
+            << " " << cost_pl->value();
+        for (const auto b: cost_pl->breakpoints()) {
+            s << " " << b;
+        }
+        for (const auto slope: cost_pl->slopes()) {
+            s << " " << slope;
+        }
     } else if (std::holds_alternative<CostFunction::VirtualObjective>(cost_func)) {
         // TODO: if we ever need this, have user supply custom serializer
         throw std::runtime_error("Satsuma::write_cost: Saving virtual cost functions is not supported.");
@@ -1,6 +1,7 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #pragma once
+#include <libsatsuma/Config/Scalars.hh>
 #include <libsatsuma/Problems/BidirectedGraph.hh>
 #include <limits>
 
@@ -15,7 +16,7 @@ struct BiFlowGraph : public BidirectedGraph
     using Edge = BidirectedGraph::Edge;
     using Arc = BidirectedGraph::Arc;
 
-    using FlowScalar = int;
+    using FlowScalar = FlowInt;
 
     // TODO: rename Solution & Guess to Flow?
     using Solution = EdgeMap<FlowScalar>; /// A valid, conservative flow
@@ -26,8 +26,8 @@ struct BiMCF : public BiFlowGraph
         Node u, v;
         bool u_head, v_head;
         CostScalar cost = 0.;
-        int lower = 0;
-        int upper = inf();
+        FlowScalar lower = 0;
+        FlowScalar upper = inf();
     };
     inline Edge add_edge(EdgeInfo const &info)
     {
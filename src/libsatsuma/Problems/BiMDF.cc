@@ -2,6 +2,8 @@
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Problems/BiMDF.hh>
 #include <libsatsuma/Problems/BiMCF.hh>
+#include <libsatsuma/Problems/CostBatch.hh>
+#include <libsatsuma/Problems/CostTable.hh>
 #include <libsatsuma/Reductions/BiMDF_to_BiMCF.hh>
 
 #include <cmath>
@@ -11,24 +13,20 @@ namespace Satsuma {
 
 BiMDF::CostScalar BiMDF::cost(Edge e, double x) const
 {
+    double c;
+    if (cost_table && cost_table->lookup(g.id(e), x, c)) {
+        return c;
+    }
     return CostFunction::cost(cost_function[e], x);
 }
 
 BiMDF::CostScalar BiMDF::cost(Solution const&sol) const
 {
-    double sum = 0;
-    for (auto e: g.edges()) {
-        sum += cost(e, sol[e]);
-    }
-    return sum;
+    return CostBatch(*this).cost(sol);
 }
 BiMDF::CostScalar BiMDF::cost_half(Solution const&sol) const
 {
-    double sum = 0;
-    for (auto e: g.edges()) {
-        sum += cost(e, .5 * sol[e]);
-    }
-    return sum;
+    return CostBatch(*this).cost(sol, .5);
 }
 
 } // namespace Satsuma
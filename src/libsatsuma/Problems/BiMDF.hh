@@ -10,6 +10,7 @@
 
 namespace Satsuma {
 
+class CostTable;
 
 /// Minimum-deviation flow in bidirected graphs
 struct BiMDF : public BiFlowGraph
@@ -28,6 +29,9 @@ struct BiMDF : public BiFlowGraph
     using CostScalar = double;
 
     EdgeMap<CostFunction::Function> cost_function {g};
+    /// Optional precomputed costs read by cost(Edge, double), see CostTable::Scope.
+    /// The solver only installs it on its own sub-problems, never on the input.
+    std::shared_ptr<const CostTable> cost_table;
 
     struct EdgeInfo {
         Node u, v;
@@ -0,0 +1,152 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Problems/CostBatch.hh>
+#include <libsatsuma/Problems/CostTable.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Satsuma {
+
+CostBatch::CostBatch(BiMDF const &_bimdf)
+    : bimdf_(_bimdf)
+{
+    for (const auto e: bimdf_.g.edges()) {
+        const int id = bimdf_.g.id(e);
+        const auto &f = bimdf_.cost_function[e];
+        auto push = [&](Kind kind, double target, double weight, double eps = 0.) {
+            auto &group = groups_[kind];
+            group.edge_id.push_back(id);
+            group.target.push_back(target);
+            group.weight.push_back(weight);
+            if (kind == Scale) {
+                group.eps.push_back(eps);
+            }
+        };
+        if (std::holds_alternative<CostFunction::Zero>(f)) {
+            continue;
+        } else if (auto p = std::get_if<CostFunction::AbsDeviation>(&f)) {
+            push(Abs, p->target, p->weight);
+        } else if (auto p = std::get_if<CostFunction::QuadDeviation>(&f)) {
+            push(Quad, p->target, p->weight);
+        } else if (auto p = std::get_if<CostFunction::ScaleFactor>(&f)) {
+            push(Scale, p->target, p->weight, p->eps);
+        } else {
+            scalar_edge_id_.push_back(id);
+        }
+    }
+}
+
+void CostBatch::evaluate(Kind _kind, double const *_x, double *_out) const
+{
+    const auto &group = groups_[_kind];
+    const size_t n = group.size();
+    const double *target = group.target.data();
+    const double *weight = group.weight.data();
+    switch (_kind) {
+    case Abs:
+        for (size_t i = 0; i < n; ++i) {
+            _out[i] = weight[i] * std::fabs(_x[i] - target[i]);
+        }
+        break;
+    case Quad:
+        for (size_t i = 0; i < n; ++i) {
+            const double d = _x[i] - target[i];
+            _out[i] = weight[i] * d * d;
+        }
+        break;
+    case Scale: {
+        const double *eps = group.eps.data();
+        for (size_t i = 0; i < n; ++i) {
+            const double adj_tgt = target[i] + eps[i];
+            const double adj_l = _x[i] + eps[i];
+            _out[i] = weight[i] * std::max(adj_l / adj_tgt, adj_tgt / adj_l);
+        }
+        break;
+    }
+    case N_KINDS:
+        break;
+    }
+}
+
+double CostBatch::cost(BiMDF::Solution const &_x, double _scale) const
+{
+    const auto &g = bimdf_.g;
+    std::vector<double> x;
+    std::vector<double> c;
+    double sum = 0.;
+    for (int kind = 0; kind < N_KINDS; ++kind) {
+        const auto &group = groups_[kind];
+        x.resize(group.size());
+        c.resize(group.size());
+        for (size_t i = 0; i < group.size(); ++i) {
+            x[i] = _scale * _x[g.edgeFromId(group.edge_id[i])];
+        }
+        evaluate(static_cast<Kind>(kind), x.data(), c.data());
+        sum = std::accumulate(c.begin(), c.end(), sum);
+    }
+    for (const auto id: scalar_edge_id_) {
+        const auto e = g.edgeFromId(id);
+        sum += bimdf_.cost(e, _scale * _x[e]);
+    }
+    return sum;
+}
+
+void CostBatch::evaluate_window(BiMDF::Guess const &_x, int _radius, std::vector<double> &_out) const
+{
+    const auto &g = bimdf_.g;
+    const size_t width = 2 * _radius + 1;
+    _out.assign(width * (g.maxEdgeId() + 1), 0.);
+
+    std::vector<double> x0;
+    std::vector<double> x;
+    std::vector<double> c;
+    for (int kind = 0; kind < N_KINDS; ++kind) {
+        const auto &group = groups_[kind];
+        const size_t n = group.size();
+        x0.resize(n);
+        x.resize(n);
+        c.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            x0[i] = _x[g.edgeFromId(group.edge_id[i])];
+        }
+        for (int d = -_radius; d <= _radius; ++d) {
+            for (size_t i = 0; i < n; ++i) {
+                x[i] = x0[i] + d;
+            }
+            evaluate(static_cast<Kind>(kind), x.data(), c.data());
+            const size_t offset = _radius + d;
+            for (size_t i = 0; i < n; ++i) {
+                _out[group.edge_id[i] * width + offset] = c[i];
+            }
+        }
+    }
+    // one batched query per edge, e.g. for expensive VirtualObjectives,
+    // for the values not found in an installed CostTable:
+    const CostTable *table = bimdf_.cost_table.get();
+    std::vector<size_t> missing;
+    for (const auto id: scalar_edge_id_) {
+        const auto e = g.edgeFromId(id);
+        double *out = &_out[id * width];
+        x.clear();
+        missing.clear();
+        for (int d = -_radius; d <= _radius; ++d) {
+            const double xd = _x[e] + d;
+            if (!table || !table->lookup(id, xd, out[_radius + d])) {
+                x.push_back(xd);
+                missing.push_back(_radius + d);
+            }
+        }
+        if (missing.empty()) {
+            continue;
+        }
+        c.resize(missing.size());
+        CostFunction::evaluate(bimdf_.cost_function[e], x, c);
+        for (size_t i = 0; i < missing.size(); ++i) {
+            out[missing[i]] = c[i];
+        }
+    }
+}
+
+} // namespace Satsuma
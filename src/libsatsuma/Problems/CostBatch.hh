@@ -0,0 +1,51 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Config/Export.hh>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <vector>
+
+namespace Satsuma {
+
+/// Batch evaluation of the edge costs of a BiMDF.
+/// Edges are grouped by cost function type, with the parameters of each group
+/// stored in contiguous arrays, so that each group is evaluated in a simple loop
+/// without per-edge dispatch that the compiler can vectorize.
+/// Other types (PiecewiseLinear, VirtualObjective, Sum) are evaluated edge by edge.
+/// The layout is a snapshot: it does not follow later changes to the BiMDF.
+class SATSUMA_EXPORT CostBatch
+{
+public:
+    using Edge = BiMDF::Edge;
+
+    explicit CostBatch(BiMDF const &_bimdf);
+
+    /// Total cost of the flow `_scale * _x`, same as BiMDF::cost(Solution)
+    /// up to summation order.
+    double cost(BiMDF::Solution const &_x, double _scale = 1.) const;
+
+    /// Cost of every edge e at `_x[e] + d` for d in [-_radius, _radius], stored at
+    /// `_out[id(e) * (2 * _radius + 1) + _radius + d]`. Entries for unused edge ids are 0.
+    /// Values of the edge-by-edge types are read from an installed CostTable where possible.
+    void evaluate_window(BiMDF::Guess const &_x, int _radius, std::vector<double> &_out) const;
+
+private:
+    struct Group {
+        std::vector<int> edge_id;
+        std::vector<double> target;
+        std::vector<double> weight;
+        std::vector<double> eps; // ScaleFactor only
+        size_t size() const {return edge_id.size();}
+    };
+    enum Kind {Abs, Quad, Scale, N_KINDS};
+
+    /// `_out[i] = f_i(_x[i])` for all edges i of group `_kind`.
+    void evaluate(Kind _kind, double const *_x, double *_out) const;
+
+    BiMDF const &bimdf_;
+    Group groups_[N_KINDS];
+    std::vector<int> scalar_edge_id_; // other types
+};
+
+} // namespace Satsuma
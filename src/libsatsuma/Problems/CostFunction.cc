@@ -1,7 +1,261 @@
 #include <libsatsuma/Problems/CostFunction.hh>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
 
 namespace Satsuma::CostFunction {
 
+PiecewiseLinear::PiecewiseLinear(std::vector<double> _breakpoints, std::vector<double> _slopes, double _value)
+{
+    auto data = std::make_shared<Data>(Data{
+            .breakpoints = std::move(_breakpoints),
+            .slopes = std::move(_slopes),
+            .value = _value,
+            .values = {}});
+    data_ = data;
+    const auto &bp = data->breakpoints;
+    const auto &slopes = data->slopes;
+    if (slopes.size() != bp.size() + 1) {
+        throw std::invalid_argument("PiecewiseLinear: need one more slope than breakpoints");
+    }
+    if (std::adjacent_find(bp.begin(), bp.end(), std::greater_equal<>()) != bp.end()) {
+        throw std::invalid_argument("PiecewiseLinear: breakpoints must be strictly increasing");
+    }
+    if (std::adjacent_find(slopes.begin(), slopes.end(), std::greater<>()) != slopes.end()) {
+        throw std::invalid_argument("PiecewiseLinear: slopes must be non-decreasing (convexity)");
+    }
+    if (bp.empty()) {
+        return;
+    }
+    auto &values = data->values;
+    values.resize(bp.size());
+    values[0] = data->value;
+    for (size_t i = 1; i < bp.size(); ++i) {
+        values[i] = values[i - 1] + slopes[i] * (bp[i] - bp[i - 1]);
+    }
+    // first breakpoint with non-negative slope to its right:
+    auto it = std::find_if(slopes.begin() + 1, slopes.end(), [](double s) {return s >= 0;});
+    data->guess = bp[std::min<size_t>(it - slopes.begin() - 1, bp.size() - 1)];
+}
+
+// Every edge of a BiMDF stores a Function, keep it small:
+// Sum and PiecewiseLinear share their (immutable) data between copies.
+static_assert(sizeof(Function) <= 4 * sizeof(double));
+
 BaseObjective::~BaseObjective() = default;
 
+void BaseObjective::evaluate(std::span<const double> _x, std::span<double> _out) const
+{
+    for (size_t i = 0; i < _x.size(); ++i) {
+        _out[i] = (*this)(_x[i]);
+    }
+}
+
+double BaseObjective::marginal(double _x) const
+{
+    return (*this)(_x + 1) - (*this)(_x);
+}
+
+namespace {
+bool equal_params(Zero const&, Zero const&) {return true;}
+bool equal_params(AbsDeviation const&a, AbsDeviation const&b) {
+    return a.target == b.target && a.weight == b.weight;
+}
+bool equal_params(QuadDeviation const&a, QuadDeviation const&b) {
+    return a.target == b.target && a.weight == b.weight;
+}
+bool equal_params(ScaleFactor const&a, ScaleFactor const&b) {
+    return a.target == b.target && a.weight == b.weight && a.eps == b.eps;
+}
+bool equal_params(PiecewiseLinear const&a, PiecewiseLinear const&b) {
+    return a.value() == b.value()
+        && a.breakpoints() == b.breakpoints()
+        && a.slopes() == b.slopes();
+}
+bool equal_params(VirtualObjective const&a, VirtualObjective const&b) {
+    return a.obj_ == b.obj_;
+}
+bool equal_params(Sum const&a, Sum const&b) {
+    return a.size() == b.size()
+        && std::equal(a.begin(), a.end(), b.begin(),
+                      [](auto const &x, auto const &y) {return CostFunction::equal(x, y);});
+}
+
+void hash_combine(size_t &seed, size_t v) {
+    seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+size_t hash_params(Zero const&) {return 0;}
+size_t hash_params(AbsDeviation const&f) {
+    size_t h = std::hash<double>{}(f.target);
+    hash_combine(h, std::hash<double>{}(f.weight));
+    return h;
+}
+size_t hash_params(QuadDeviation const&f) {
+    size_t h = std::hash<double>{}(f.target);
+    hash_combine(h, std::hash<double>{}(f.weight));
+    return h;
+}
+size_t hash_params(ScaleFactor const&f) {
+    size_t h = std::hash<double>{}(f.target);
+    hash_combine(h, std::hash<double>{}(f.weight));
+    hash_combine(h, std::hash<double>{}(f.eps));
+    return h;
+}
+size_t hash_params(PiecewiseLinear const&f) {
+    size_t h = std::hash<double>{}(f.value());
+    for (const auto b: f.breakpoints()) {
+        hash_combine(h, std::hash<double>{}(b));
+    }
+    for (const auto s: f.slopes()) {
+        hash_combine(h, std::hash<double>{}(s));
+    }
+    return h;
+}
+size_t hash_params(VirtualObjective const&f) {
+    return std::hash<BaseObjective*>{}(f.obj_.get());
+}
+size_t hash_params(Sum const&f) {
+    size_t h = f.size();
+    for (const auto &component: f) {
+        hash_combine(h, CostFunction::hash(component));
+    }
+    return h;
+}
+long long clamped_round(double x, long long _lower, long long _upper) {
+    return std::clamp(std::llround(x), _lower, _upper);
+}
+long long argmin_params(Zero const&f, long long _lower, long long _upper) {
+    return clamped_round(f.guess, _lower, _upper);
+}
+long long argmin_params(AbsDeviation const&f, long long _lower, long long _upper) {
+    return clamped_round(f.target, _lower, _upper);
+}
+long long argmin_params(QuadDeviation const&f, long long _lower, long long _upper) {
+    return clamped_round(f.target, _lower, _upper);
+}
+long long argmin_params(ScaleFactor const&f, long long _lower, long long _upper) {
+    // not symmetric around the target: compare both neighbors
+    const auto floor = std::clamp(std::llround(std::floor(f.target)), _lower, _upper);
+    const auto ceil = std::clamp(std::llround(std::ceil(f.target)), _lower, _upper);
+    return f(ceil) < f(floor) ? ceil : floor;
+}
+long long argmin_params(PiecewiseLinear const&f, long long _lower, long long _upper) {
+    if (f.slopes().front() >= 0) {
+        return _lower;
+    }
+    if (f.slopes().back() < 0) {
+        return _upper;
+    }
+    const auto m = f.get_guess();
+    const auto floor = std::clamp(std::llround(std::floor(m)), _lower, _upper);
+    const auto ceil = std::clamp(std::llround(std::ceil(m)), _lower, _upper);
+    return f(ceil) < f(floor) ? ceil : floor;
+}
+long long argmin_params(VirtualObjective const&f, long long _lower, long long _upper) {
+    // Galloping search from the guess for a range containing the smallest minimizer,
+    // i.e. the first x with f(x+1) >= f(x), then binary search within it.
+    auto marginal = [&f](double x) {return f.marginal(x);};
+    auto at_or_past_min = [&f](long long x) {
+        return f.marginal(static_cast<double>(x)) >= 0;
+    };
+    const auto x0 = clamped_round(f.get_guess(), _lower, _upper);
+    auto lo = x0;
+    auto hi = x0;
+    if (x0 < _upper && !at_or_past_min(x0)) {
+        lo = x0 + 1;
+        for (long long step = 1; ; step *= 2) {
+            const auto y = x0 + step;
+            if (y >= _upper) {
+                hi = _upper;
+                break;
+            }
+            if (at_or_past_min(y)) {
+                hi = y;
+                break;
+            }
+            lo = y + 1;
+        }
+    } else {
+        for (long long step = 1; ; step *= 2) {
+            const auto y = x0 - step;
+            if (y <= _lower) {
+                lo = _lower;
+                break;
+            }
+            if (!at_or_past_min(y)) {
+                lo = y + 1;
+                break;
+            }
+            hi = y;
+        }
+    }
+    return convex_argmin(marginal, lo, hi);
+}
+long long argmin_params(Sum const&f, long long _lower, long long _upper) {
+    if (f.size() == 0) {
+        return clamped_round(0., _lower, _upper);
+    }
+    return convex_argmin([&f](double x) {return f.marginal(x);},
+            std::clamp(std::llround(f.min_guess()), _lower, _upper),
+            std::clamp(std::llround(f.max_guess()), _lower, _upper));
+}
+} // namespace
+
+void evaluate(Function const&f, std::span<const double> _x, std::span<double> _out)
+{
+    if (auto vo = std::get_if<VirtualObjective>(&f)) {
+        vo->evaluate(_x, _out);
+    } else if (auto sum = std::get_if<Sum>(&f)) {
+        std::fill(_out.begin(), _out.end(), 0.);
+        std::vector<double> component_out(_x.size());
+        for (const auto &component: *sum) {
+            evaluate(component, _x, component_out);
+            for (size_t i = 0; i < _x.size(); ++i) {
+                _out[i] += component_out[i];
+            }
+        }
+    } else {
+        for (size_t i = 0; i < _x.size(); ++i) {
+            _out[i] = cost(f, _x[i]);
+        }
+    }
+}
+
+double marginal(Function const&f, double _x)
+{
+    return std::visit([_x](const auto &o) -> double {
+        using T = std::decay_t<decltype(o)>;
+        if constexpr (std::is_same_v<T, VirtualObjective> || std::is_same_v<T, Sum>) {
+            return o.marginal(_x);
+        } else {
+            return o(_x + 1) - o(_x);
+        }
+    }, f);
+}
+
+long long argmin(Function const&f, long long _lower, long long _upper)
+{
+    return std::visit([&](const auto &o) -> long long {
+        return argmin_params(o, _lower, _upper);
+    }, f);
+}
+
+bool equal(Function const&a, Function const&b)
+{
+    if (a.index() != b.index()) {
+        return false;
+    }
+    return std::visit([&b](const auto &fa) -> bool {
+        return equal_params(fa, std::get<std::decay_t<decltype(fa)>>(b));
+    }, a);
+}
+
+size_t hash(Function const&f)
+{
+    size_t h = f.index();
+    hash_combine(h, std::visit([](const auto &o) -> size_t {return hash_params(o);}, f));
+    return h;
+}
+
 } // namespace
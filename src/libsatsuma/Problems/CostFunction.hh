@@ -3,9 +3,11 @@
 #pragma once
 
 #include <libsatsuma/Config/Export.hh>
+#include <algorithm>
 #include <cmath>
 #include <variant>
 #include <memory>
+#include <span>
 #include <vector>
 #include <iterator>
 
@@ -46,6 +48,44 @@ struct SATSUMA_EXPORT ScaleFactor {
     double get_guess() const {return target;}
 };
 
+/// Convex piecewise-linear function with sorted breakpoints b_0 < ... < b_{k-1}
+/// and non-decreasing slopes s_0 <= ... <= s_k, where s_i is the slope left of b_i
+/// and s_k the slope right of b_{k-1}. f(b_0) = value, or f(x) = value + s_0 * x
+/// without breakpoints.
+class SATSUMA_EXPORT PiecewiseLinear {
+public:
+    /// Throws std::invalid_argument if the function is not convex or malformed.
+    PiecewiseLinear(std::vector<double> _breakpoints, std::vector<double> _slopes, double _value = 0.);
+    double operator()(double l) const {
+        const auto &bp = data_->breakpoints;
+        const auto &slopes = data_->slopes;
+        if (bp.empty()) {
+            return data_->value + slopes[0] * l;
+        }
+        // number of breakpoints <= l:
+        const auto i = std::upper_bound(bp.begin(), bp.end(), l) - bp.begin();
+        if (i == 0) {
+            return data_->values[0] + slopes[0] * (l - bp[0]);
+        }
+        return data_->values[i - 1] + slopes[i] * (l - bp[i - 1]);
+    }
+    /// Smallest minimizer, or the outermost breakpoint in the descent direction if unbounded.
+    double get_guess() const {return data_->guess;}
+    std::vector<double> const& breakpoints() const {return data_->breakpoints;}
+    std::vector<double> const& slopes() const {return data_->slopes;}
+    double value() const {return data_->value;}
+private:
+    struct Data {
+        std::vector<double> breakpoints;
+        std::vector<double> slopes;
+        double value;
+        std::vector<double> values; // at breakpoints
+        double guess = 0.;
+    };
+    /// Immutable, shared between copies to keep Function small.
+    std::shared_ptr<const Data> data_;
+};
+
 /// For VirtualObjective
 struct SATSUMA_EXPORT BaseObjective {
     virtual ~BaseObjective();
@@ -53,26 +93,64 @@ struct SATSUMA_EXPORT BaseObjective {
     virtual double operator()(double) const = 0;
     /// Get the minimum parameter value or another decent initial value.
     virtual double get_guess() const = 0;
+    /// Evaluate f at all `_x` (same size as `_out`).
+    /// Override if evaluating several values at once is cheaper.
+    virtual void evaluate(std::span<const double> _x, std::span<double> _out) const;
+    /// Marginal cost f(x+1) - f(x).
+    /// Override if it can be computed more cheaply than two evaluations.
+    virtual double marginal(double _x) const;
 };
 
 /// User-defined convex(!) cost functions
 struct SATSUMA_EXPORT VirtualObjective {
     double operator()(double l) const {return (*obj_)(l);}
     double get_guess() const {return obj_->get_guess();}
+    void evaluate(std::span<const double> _x, std::span<double> _out) const {obj_->evaluate(_x, _out);}
+    double marginal(double _x) const {return obj_->marginal(_x);}
     /// shared_ptr so we can copy-assign this.
     std::shared_ptr<BaseObjective> obj_;
 };
 
 struct SATSUMA_EXPORT Sum;
 //using BasicFunction = std::variant<Zero, AbsDeviation, QuadDeviation, VirtualObjective>;
-using Function = std::variant<Zero, AbsDeviation, QuadDeviation, ScaleFactor, VirtualObjective, Sum>;
+using Function = std::variant<Zero, AbsDeviation, QuadDeviation, ScaleFactor, PiecewiseLinear, VirtualObjective, Sum>;
 double cost(Function const&f, double _l);
 double get_guess(Function const&f);
+/// `_out[i] = f(_x[i])`, batched for VirtualObjective (also inside of Sums).
+SATSUMA_EXPORT void evaluate(Function const&f, std::span<const double> _x, std::span<double> _out);
+/// Marginal cost f(x+1) - f(x), a single query for VirtualObjective.
+SATSUMA_EXPORT double marginal(Function const&f, double _x);
+/// Same type and parameters; VirtualObjectives are only equal if they share the same object.
+SATSUMA_EXPORT bool equal(Function const&a, Function const&b);
+/// Hash value consistent with `equal`.
+SATSUMA_EXPORT size_t hash(Function const&f);
+/// Smallest integer minimizer of `f` in [_lower, _upper] (requires _lower <= _upper).
+/// Closed-form for the basic types, binary search for Sum and VirtualObjective.
+SATSUMA_EXPORT long long argmin(Function const&f, long long _lower, long long _upper);
+
+/// Smallest integer minimizer of a convex function in [_lower, _upper] (requires _lower <= _upper),
+/// by binary search for the first non-negative marginal cost f(x+1) - f(x).
+template<typename Marginal>
+long long convex_argmin(Marginal const &_marginal, long long _lower, long long _upper)
+{
+    while (_lower < _upper) {
+        const auto mid = _lower + (_upper - _lower) / 2;
+        if (_marginal(static_cast<double>(mid)) < 0) {
+            _lower = mid + 1;
+        } else {
+            _upper = mid;
+        }
+    }
+    return _lower;
+}
 
 /// Sum of other types of cost functions
 struct SATSUMA_EXPORT Sum {
     Sum(auto _begin, auto _end) {
-        components_.reserve(std::distance(_begin, _end));
+        auto data = std::make_shared<Data>();
+        data_ = data;
+        auto &components = data->components;
+        components.reserve(std::distance(_begin, _end));
         auto min_guess = std::numeric_limits<double>::infinity();
         auto max_guess = -std::numeric_limits<double>::infinity();
         for (auto it = _begin; it != _end; ++it) {
@@ -84,40 +162,40 @@ struct SATSUMA_EXPORT Sum {
             max_guess = std::max(max_guess, g);
             // ensure a flat list of components:
             if (auto sump = std::get_if<Sum>(&*it)) {
-                std::copy(sump->begin(), sump->end(), std::back_inserter(components_));
+                std::copy(sump->begin(), sump->end(), std::back_inserter(components));
             } else {
-                components_.push_back(*it);
+                components.push_back(*it);
             }
         }
-        // Find integer guess in the range of component guesses.
-        // PERF: Runtime could be improved by a variant of binary search, relying on convexity;
-        //       For now, assume the range is small enough that it does not matter.
-        auto best_cost = std::numeric_limits<double>::infinity();
-        auto last_cost = std::numeric_limits<double>::infinity();
-        for (auto g = std::llround(std::floor(min_guess));
-             g <= std::llround(std::ceil(max_guess));
-             ++g)
-        {
-            auto c = (*this)(g);
-            if (c > last_cost) {
-                // We are past the minimum of the convex function
-                break;
-            }
-            last_cost = c;
-            if (c < best_cost) {
-                guess_ = g;
-                best_cost = c;
-            }
+        if (components.empty()) {
+            return;
         }
+        // The minimum lies in the range of component guesses:
+        data->min_guess = std::floor(min_guess);
+        data->max_guess = std::ceil(max_guess);
+        data->guess = static_cast<double>(convex_argmin(
+                    [this](double x) {return marginal(x);},
+                    std::llround(data->min_guess),
+                    std::llround(data->max_guess)));
     }
     double operator()(double l) const;
-    double get_guess() const {return guess_;};
-    auto begin() const {return components_.cbegin();}
-    auto end() const {return components_.end();}
-    size_t size() const {return components_.size();}
+    double marginal(double l) const;
+    double get_guess() const {return data_->guess;};
+    auto begin() const {return data_->components.cbegin();}
+    auto end() const {return data_->components.cend();}
+    size_t size() const {return data_->components.size();}
+    /// Integer range that contains the minimum
+    double min_guess() const {return data_->min_guess;}
+    double max_guess() const {return data_->max_guess;}
 private:
-    std::vector<Function> components_;
-    double guess_ = 0.;
+    struct Data {
+        std::vector<Function> components;
+        double guess = 0.;
+        double min_guess = 0.;
+        double max_guess = 0.;
+    };
+    /// Immutable after construction, shared between copies to keep Function small.
+    std::shared_ptr<const Data> data_;
 };
 
 /// obj should be some variant of functions, e.g. Function
@@ -132,9 +210,17 @@ inline double get_guess(Function const&f) {
 
 inline double Sum::operator()(double l) const {
     double c = 0.;
-    for (const auto &obj: components_) {
+    for (const auto &obj: *this) {
         c += cost(obj, l);
     }
     return c;
 }
+
+inline double Sum::marginal(double l) const {
+    double c = 0.;
+    for (const auto &obj: *this) {
+        c += CostFunction::marginal(obj, l);
+    }
+    return c;
+}
 } // namespace Objective
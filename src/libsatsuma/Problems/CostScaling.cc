@@ -0,0 +1,66 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Problems/CostScaling.hh>
+#include <libsatsuma/Problems/BiMCF.hh>
+#include <libsatsuma/Exceptions.hh>
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace Satsuma {
+
+CostScaling::CostScaling(double _max_magnitude, double _max_multiplier, double _limit)
+    : multiplier_(_max_multiplier)
+    , limit_(_limit)
+{
+    if (!std::isfinite(_max_magnitude)) {
+        throw CostOverflowError("CostScaling: costs are not finite");
+    }
+    if (_max_magnitude * multiplier_ > limit()) {
+        // largest power of two m with m * magnitude <= limit
+        int exp = 0;
+        std::frexp(limit() / _max_magnitude, &exp);
+        multiplier_ = std::ldexp(1., exp - 1);
+    }
+}
+
+CostScaling::IntScalar CostScaling::scale(double _cost) const
+{
+    const double scaled = _cost * multiplier_;
+    if (!(std::fabs(scaled) <= limit())) {
+        throw CostOverflowError("CostScaling: cost " + std::to_string(_cost)
+                                + " too high for multiplier " + std::to_string(multiplier_));
+    }
+    return std::llround(scaled);
+}
+
+double abs_cost_sum(BiMCF const &_bimcf)
+{
+    double sum = 0.;
+    for (const auto e: _bimcf.g.edges()) {
+        sum += std::fabs(_bimcf.cost[e]);
+    }
+    return sum;
+}
+
+CostAccumulator::IntScalar CostAccumulator::value() const
+{
+    constexpr auto lo = std::numeric_limits<IntScalar>::min();
+    constexpr auto hi = std::numeric_limits<IntScalar>::max();
+#if SATSUMA_HAVE_INT128
+    if (sum_ < lo || sum_ > hi) {
+        throw CostOverflowError("CostAccumulator: total cost exceeds 64 bits");
+    }
+    return static_cast<IntScalar>(sum_);
+#else
+    // the shadow sum is inexact, so stay clear of the limits
+    if (!(std::fabs(shadow_) < .5 * static_cast<double>(hi))) {
+        throw CostOverflowError("CostAccumulator: total cost exceeds 64 bits");
+    }
+    (void)lo;
+    return sum_;
+#endif
+}
+
+} // namespace Satsuma
@@ -0,0 +1,89 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Config/Export.hh>
+#include <cstdint>
+
+#if defined(__SIZEOF_INT128__)
+#  define SATSUMA_HAVE_INT128 1
+#else
+#  define SATSUMA_HAVE_INT128 0
+#endif
+
+namespace Satsuma {
+
+struct BiMCF;
+
+/// Conversion of floating-point costs to the 64-bit integer costs of the
+/// MCF and matching solvers: costs are multiplied by a power of two and rounded.
+///
+/// The multiplier is the largest one (at most `_max_multiplier`) for which
+/// `_max_magnitude` times the multiplier stays below `limit()`, by default
+/// `default_limit`; solvers with a smaller integer type need a lower `_limit`.
+/// `_max_magnitude` bounds the unscaled absolute value of any cost sum the solver
+/// forms internally, e.g. potentials along paths, typically the sum of absolute costs.
+/// Instances with small costs keep the full precision of `_max_multiplier`,
+/// large ones lose low-order bits instead of overflowing.
+/// As long as no instance needs a smaller multiplier, scaled costs and potentials
+/// of different reductions are directly comparable.
+class SATSUMA_EXPORT CostScaling
+{
+public:
+    using IntScalar = std::int64_t;
+    /// Determines the precision for small costs
+    static constexpr double default_max_multiplier = 1 << 20;
+    /// Leaves headroom in 64 bits for solver-internal artificial costs.
+    static constexpr double default_limit = static_cast<double>(1LL << 60);
+
+    /// Throws CostOverflowError if `_max_magnitude` is not finite.
+    explicit CostScaling(double _max_magnitude,
+                         double _max_multiplier = default_max_multiplier,
+                         double _limit = default_limit);
+
+    double multiplier() const {return multiplier_;}
+    /// Largest absolute scaled magnitude admitted by the policy.
+    double limit() const {return limit_;}
+
+    /// Throws CostOverflowError if the scaled cost exceeds limit(),
+    /// which means `_cost` was not accounted for in the magnitude.
+    IntScalar scale(double _cost) const;
+    double unscale(IntScalar _cost) const {return _cost / multiplier_;}
+
+private:
+    double multiplier_;
+    double limit_;
+};
+
+/// Sum of absolute edge costs, bounds the potentials of MCF reductions
+/// (path costs, no path uses an edge twice).
+SATSUMA_EXPORT double abs_cost_sum(BiMCF const &_bimcf);
+
+/// Overflow-checked sum of products of 64-bit integers, e.g. the total cost of a flow.
+/// Accumulates in 128 bits if the compiler supports it, otherwise in 64 bits
+/// with a floating-point shadow sum for overflow detection.
+class SATSUMA_EXPORT CostAccumulator
+{
+public:
+    using IntScalar = std::int64_t;
+    void add(IntScalar _cost, IntScalar _count = 1) {
+#if SATSUMA_HAVE_INT128
+        sum_ += static_cast<__int128>(_cost) * _count;
+#else
+        sum_ += _cost * _count;
+        shadow_ += static_cast<double>(_cost) * _count;
+#endif
+    }
+    /// Throws CostOverflowError if the sum does not fit into 64 bits.
+    IntScalar value() const;
+
+private:
+#if SATSUMA_HAVE_INT128
+    __int128 sum_ = 0;
+#else
+    IntScalar sum_ = 0;
+    double shadow_ = 0.;
+#endif
+};
+
+} // namespace Satsuma
@@ -0,0 +1,68 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Problems/CostTable.hh>
+#include <libsatsuma/Problems/CostBatch.hh>
+
+#include <algorithm>
+
+namespace Satsuma {
+
+CostTable::CostTable(BiMDF const &_bimdf, int _radius)
+    : radius_(_radius)
+    , width_(2 * _radius + 1)
+{
+    const auto &g = _bimdf.g;
+    center_.assign(g.maxEdgeId() + 1, 0);
+    BiMDF::Guess center(g);
+    for (const auto e: g.edges()) {
+        auto c = static_cast<BiMDF::FlowScalar>(std::llround(_bimdf.guess(e)));
+        c = std::clamp<BiMDF::FlowScalar>(c, _bimdf.lower[e], std::max(_bimdf.lower[e], _bimdf.upper[e]));
+        center[e] = c;
+        center_[g.id(e)] = c;
+    }
+    CostBatch(_bimdf).evaluate_window(center, radius_, cost_);
+}
+
+bool CostTable::argmin(int _edge_id, long long _lower, long long _upper, long long &_x) const
+{
+    if (_edge_id < 0 || static_cast<size_t>(_edge_id) >= center_.size()) {
+        return false;
+    }
+    const long long c = center_[_edge_id];
+    const long long lo = std::max<long long>(_lower, c - radius_);
+    const long long hi = std::min<long long>(_upper, c + radius_);
+    if (lo > hi) {
+        return false;
+    }
+    auto cost = [&](long long x) {return cost_[_edge_id * width_ + radius_ + (x - c)];};
+    long long best = lo;
+    for (long long x = lo + 1; x <= hi; ++x) {
+        if (cost(x) < cost(best)) {
+            best = x;
+        }
+    }
+    // by convexity, a minimum inside of the window is global
+    if ((best == lo && lo > _lower) || (best == hi && hi < _upper)) {
+        return false;
+    }
+    _x = best;
+    return true;
+}
+
+CostTable::Scope::Scope(BiMDF &_bimdf, int _radius)
+    : bimdf_(_bimdf)
+{
+    if (_radius > 0 && !bimdf_.cost_table) {
+        bimdf_.cost_table = std::make_shared<CostTable>(bimdf_, _radius);
+        installed_ = true;
+    }
+}
+
+CostTable::Scope::~Scope()
+{
+    if (installed_) {
+        bimdf_.cost_table.reset();
+    }
+}
+
+} // namespace Satsuma
@@ -0,0 +1,64 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Config/Export.hh>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace Satsuma {
+
+/// Precomputed costs of every edge of a BiMDF at the integer flow values in a window
+/// [c - radius, c + radius] around its rounded guess c (clamped to the edge bounds).
+/// The double cover and refinement stages evaluate costs around the guess repeatedly,
+/// which is expensive for VirtualObjective and large Sums (e.g. from simplification).
+///
+/// While installed (see Scope), BiMDF::cost(Edge, double) reads from the table,
+/// and falls back to evaluating the cost function outside of the window.
+/// The table is a snapshot: the BiMDF must not be modified while it is installed.
+class SATSUMA_EXPORT CostTable
+{
+public:
+    CostTable(BiMDF const &_bimdf, int _radius);
+
+    /// Look up the cost of edge `_edge_id` at `_x`; false if not in the table.
+    bool lookup(int _edge_id, double _x, double &_cost) const {
+        if (_edge_id < 0 || static_cast<size_t>(_edge_id) >= center_.size()) {
+            return false;
+        }
+        const double d = _x - center_[_edge_id];
+        if (!(std::fabs(d) <= radius_) || d != std::floor(d)) {
+            return false;
+        }
+        _cost = cost_[_edge_id * width_ + radius_ + static_cast<int>(d)];
+        return true;
+    }
+    int radius() const {return radius_;}
+    /// Smallest integer minimizer of edge `_edge_id` in [_lower, _upper] (see CostFunction::argmin),
+    /// false if the window does not determine it.
+    bool argmin(int _edge_id, long long _lower, long long _upper, long long &_x) const;
+
+    /// Install a new table in a BiMDF for the lifetime of the Scope.
+    /// Does nothing if `_radius` is <= 0 or the BiMDF already has a table.
+    /// The BiMDF must not be shared with other threads while the Scope is created or destroyed.
+    class SATSUMA_EXPORT Scope {
+    public:
+        Scope(BiMDF &_bimdf, int _radius);
+        ~Scope();
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    private:
+        BiMDF &bimdf_;
+        bool installed_ = false;
+    };
+
+private:
+    int radius_;
+    size_t width_;
+    std::vector<BiMDF::FlowScalar> center_; // by edge id
+    std::vector<double> cost_;
+};
+
+} // namespace Satsuma
@@ -0,0 +1,90 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Problems/CostTable.hh>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <variant>
+
+namespace Satsuma {
+
+/// Call `_f(std::type_identity<T>{})`, where T is AbsDeviation or QuadDeviation
+/// if all edges of `_bimdf` (except for Zero edges) use this cost function type,
+/// or CostFunction::Function otherwise.
+/// Lets hot loops be instantiated for a single cost type, with the variant as fallback.
+template<typename F>
+decltype(auto) with_homogeneous_cost_type(BiMDF const &_bimdf, F &&_f)
+{
+    bool all_abs = true;
+    bool all_quad = true;
+    for (const auto e: _bimdf.g.edges()) {
+        const auto &f = _bimdf.cost_function[e];
+        if (std::holds_alternative<CostFunction::Zero>(f)) {
+            continue;
+        }
+        all_abs = all_abs && std::holds_alternative<CostFunction::AbsDeviation>(f);
+        all_quad = all_quad && std::holds_alternative<CostFunction::QuadDeviation>(f);
+        if (!all_abs && !all_quad) {
+            break;
+        }
+    }
+    if (all_abs) {
+        return _f(std::type_identity<CostFunction::AbsDeviation>{});
+    } else if (all_quad) {
+        return _f(std::type_identity<CostFunction::QuadDeviation>{});
+    }
+    return _f(std::type_identity<CostFunction::Function>{});
+}
+
+/// Cost of edge `_e` at `_x`, given the cost type T from with_homogeneous_cost_type.
+template<typename T>
+double edge_cost(BiMDF const &_bimdf, BiMDF::Edge _e, double _x)
+{
+    if constexpr (std::is_same_v<T, CostFunction::Function>) {
+        return _bimdf.cost(_e, _x);
+    } else {
+        const auto f = std::get_if<T>(&_bimdf.cost_function[_e]);
+        return f ? (*f)(_x) : 0.; // otherwise Zero
+    }
+}
+
+/// Guess of edge `_e`, given the cost type T from with_homogeneous_cost_type.
+template<typename T>
+double edge_guess(BiMDF const &_bimdf, BiMDF::Edge _e)
+{
+    if constexpr (std::is_same_v<T, CostFunction::Function>) {
+        return _bimdf.guess(_e);
+    } else {
+        const auto &cf = _bimdf.cost_function[_e];
+        const auto f = std::get_if<T>(&cf);
+        return f ? f->target : std::get<CostFunction::Zero>(cf).guess;
+    }
+}
+
+/// Smallest integer minimizer of the cost of edge `_e` in [_lower, _upper],
+/// given the cost type T from with_homogeneous_cost_type.
+template<typename T>
+long long edge_argmin(BiMDF const &_bimdf, BiMDF::Edge _e, long long _lower, long long _upper)
+{
+    if constexpr (std::is_same_v<T, CostFunction::Function>) {
+        const auto &f = _bimdf.cost_function[_e];
+        long long x;
+        // the search of the expensive types can be served from the table
+        if (_bimdf.cost_table
+                && (std::holds_alternative<CostFunction::VirtualObjective>(f)
+                    || std::holds_alternative<CostFunction::Sum>(f))
+                && _bimdf.cost_table->argmin(_bimdf.g.id(_e), _lower, _upper, x))
+        {
+            return x;
+        }
+        return CostFunction::argmin(f, _lower, _upper);
+    } else {
+        // symmetric around the target
+        return std::clamp(std::llround(edge_guess<T>(_bimdf, _e)), _lower, _upper);
+    }
+}
+
+} // namespace Satsuma
@@ -1,17 +1,18 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #include "MCF.hh"
+#include <libsatsuma/Problems/CostScaling.hh>
 
 
 namespace Satsuma {
 
 MCF::CostScalar MCF::compute_cost(const Solution &sol) const
 {
-    MCF::CostScalar sum = 0;
+    CostAccumulator sum;
     for (auto a: g.arcs()) {
-        sum += cost[a] * sol[a];
+        sum.add(cost[a], sol[a]);
     }
-    return sum;
+    return sum.value();
 }
 
 MCF::FlowScalar MCF::inflow(MCF::Node n, MCF::Solution const&sol) const
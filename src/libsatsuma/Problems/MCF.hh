@@ -2,6 +2,7 @@
 //  SPDX-License-Identifier: MIT
 #pragma once
 
+#include <libsatsuma/Config/Scalars.hh>
 #include <lemon/list_graph.h>
 #include <limits>
 
@@ -16,7 +17,7 @@ struct MCF
     template<typename T> using ArcMap = typename GraphT::ArcMap<T>;
     template<typename T> using NodeMap = typename GraphT::NodeMap<T>;
     using CostScalar = int64_t;
-    using FlowScalar = int;
+    using FlowScalar = FlowInt;
 
     static FlowScalar inf() {return std::numeric_limits<FlowScalar>::max();}
 
@@ -57,6 +58,9 @@ struct MCF
 struct MCFResult {
     std::unique_ptr<MCF::Solution> solution;
     MCF::CostScalar cost;
+    /// Optional dual solution: cost[a] + potential[source] - potential[target] >= 0
+    /// for all arcs `a` with residual capacity.
+    std::unique_ptr<MCF::NodeMap<MCF::CostScalar>> potential = {};
 };
 
 
@@ -1,19 +1,20 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #include "Matching.hh"
+#include <libsatsuma/Problems/CostScaling.hh>
 
 namespace Satsuma {
 
 
 Matching::WeightScalar Matching::cost(Matching::Solution const& _sol) const
 {
-    Matching::WeightScalar sum = 0;
+    CostAccumulator sum;
     for (const auto e: g.edges()) {
         if (_sol[e]) {
-            sum += weight[e];
+            sum.add(weight[e]);
         }
     }
-    return sum;
+    return sum.value();
 }
 
 bool Matching::is_perfect(const Matching::Solution &sol) const
@@ -2,6 +2,7 @@
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Reductions/BMatching_to_Matching.hh>
 #include <libsatsuma/Solvers/Matching.hh>
+#include <algorithm>
 #include <limits>
 #include <cassert>
 #include <cmath>
@@ -66,6 +67,15 @@ BMatching_to_Matching::BMatching_to_Matching(const BMatching &_bmatching,
     {
         throw std::runtime_error("graph too big, switch first_*_id to size_t?");
     }
+    // Dual values of the matching solver are bounded by a small multiple of the
+    // largest weight, the matching weight by that times the number of matched edges.
+    double max_abs_weight = 0.;
+    for (auto bmp_edge: bmatching_.g.edges()) {
+        max_abs_weight = std::max(max_abs_weight, std::fabs(bmatching_.weight[bmp_edge]));
+    }
+    cost_scaling_ = CostScaling(4. * max_abs_weight * (n_nodes / 2 + 1),
+                                CostScaling::default_max_multiplier,
+                                _config.max_scaled_weight);
     matching_.g.reserveNode(n_nodes);
     matching_.g.reserveEdge(n_edges);
 
@@ -89,7 +99,7 @@ BMatching_to_Matching::BMatching_to_Matching(const BMatching &_bmatching,
         auto demand_u = bmatching_.degree[u];
         auto demand_v = bmatching_.degree[v];
         auto cap = bmatching_.capacity[bmp_edge];
-        Matching::CostScalar weight = std::llround(costmul_ * bmatching_.weight[bmp_edge]);
+        Matching::CostScalar weight = cost_scaling_.scale(bmatching_.weight[bmp_edge]);
 
 #if 0
         std::cout << "\tconnecting "
@@ -174,7 +184,7 @@ BMatchingResult BMatching_to_Matching::translate_solution(const MatchingResult &
     if (!bmatching_.is_valid(*sol)) {
         throw std::runtime_error("B-matching solution kaput");
     }
-    return {.solution = std::move(sol), .weight = matching_result.weight / costmul_};
+    return {.solution = std::move(sol), .weight = cost_scaling_.unscale(matching_result.weight)};
 }
 
 } // namespace Satsuma
@@ -4,6 +4,7 @@
 
 #include <libsatsuma/Problems/BMatching.hh>
 #include <libsatsuma/Problems/Matching.hh>
+#include <libsatsuma/Problems/CostScaling.hh>
 
 namespace Satsuma {
 
@@ -14,6 +15,8 @@ public:
         std::unique_ptr<Matching::NodeMap<BMatching::Node>> *out_orig_node = nullptr;
         std::unique_ptr<Matching::NodeMap<int>> *out_node_num = nullptr;
         std::unique_ptr<Matching::NodeMap<BMatching::Edge>> *out_internode_edge = nullptr;
+        /// Bound on the scaled matching weights, see CostScaling and matching_weight_limit
+        double max_scaled_weight = CostScaling::default_limit;
     };
     BMatching_to_Matching(BMatching const &bm, Config const& _config = default_config);
     Matching const& matching() const { return matching_;}
@@ -23,7 +26,7 @@ private:
     BMatching const &bmatching_;
     Matching matching_;
     Matching::EdgeMap<BMatching::Edge> orig_edge{matching_.g};
-    const double costmul_ = 1LL << 20;
+    CostScaling cost_scaling_{0.};
 };
 
 } // namespace Satsuma
@@ -52,11 +52,10 @@ BiMCF_to_BMatching::BiMCF_to_BMatching(const BiMCF &_bimcf,
     // how much additional flow can enter or leave each node?
     BMatching::NodeMap<int> max_flow_in(_bimcf.g, 0);
     BMatching::NodeMap<int> max_flow_out(_bimcf.g, 0);
-    if (_config.deviation_limit == DeviationLimitKind::EdgeFlow)
     {
         for (const auto e: _bimcf.g.edges())
         {
-            auto max_inc = std::min(_bimcf.upper[e], _config.max_deviation);
+            auto max_inc = static_cast<int>(std::min<BiMCF::FlowScalar>(_bimcf.upper[e], _config.max_deviation));
             if (_bimcf.u_head[e]) {
                 max_flow_in[_bimcf.g.u(e)] += max_inc;
             } else {
@@ -73,13 +72,16 @@ BiMCF_to_BMatching::BiMCF_to_BMatching(const BiMCF &_bimcf,
     {
         auto n_in = node_in(bimcf_node);
         auto n_out = node_out(bimcf_node);
-        auto max_node_flow = max_deviation;
-        if (_config.deviation_limit == DeviationLimitKind::EdgeFlow)
+        // throughflow can not exceed the capacity of incident edges in either direction,
+        // so this bound does not change the problem but may reduce node degrees a lot
+        // (e.g. for edges with narrow deviation windows).
+        // this assumes zero demand
+        auto max_node_flow = std::min(
+                max_flow_in[bimcf_node],
+                max_flow_out[bimcf_node]);
+        if (_config.deviation_limit == DeviationLimitKind::NodeThroughflow)
         {
-            // this assumes zero demand
-            max_node_flow = std::min(
-                    max_flow_in[bimcf_node],
-                    max_flow_out[bimcf_node]);
+            max_node_flow = std::min(max_node_flow, max_deviation);
         }
 
         auto demand = bimcf_.demand[bimcf_node];
@@ -120,7 +122,9 @@ BiMCF_to_BMatching::BiMCF_to_BMatching(const BiMCF &_bimcf,
             // not bounded, add regular edge
             auto e = bmatching_.g.addEdge(u, v);
             bmatching_.weight[e] = -bimcf_.cost[mcf_edge];
-            bmatching_.capacity[e] = upper;
+            bmatching_.capacity[e] = upper == BiMCF::inf()
+                                   ? BMatching::inf()
+                                   : static_cast<BMatching::DegreeScalar>(upper);
             bm_edge_id[mcf_edge] = bmatching_.g.id(e);
 
             if (_config.out_orig_edge) {
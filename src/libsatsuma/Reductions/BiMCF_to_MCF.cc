@@ -10,17 +10,9 @@ BiMCF_to_MCF::BiMCF_to_MCF(const BiMCF &_bimcf,
                            Config const &_config)
     : bimcf_(_bimcf)
     , method_(_config.method)
+    , cost_scaling_(abs_cost_sum(_bimcf), _config.max_cost_multiplier)
 {
-    static_assert(std::numeric_limits<MCF::CostScalar>::max() >= (1LL<<63)); // for 32-bit ints, adjust costmul
-    static_assert(std::is_signed_v<MCF::CostScalar>);
-    costmul_ = 1LL << 20; // Warning: if we choose this dynamically, bimdf_lower_bound does not work anymore!
-    BiMCF::CostScalar abs_cost_sum = 0;
-    for (const auto e: _bimcf.g.edges()) {
-        abs_cost_sum += std::fabs(_bimcf.cost[e]);
-    }
-    if (abs_cost_sum > 1LL<<40) { // conservative guess
-        throw std::runtime_error("BiMCF_to_MCF: costs too high");
-    }
+    static_assert(std::is_same_v<MCF::CostScalar, CostScaling::IntScalar>);
 
     if (_config.out_orig_node) {
         *_config.out_orig_node = std::make_unique<MCF::NodeMap<BiMCF::Node>>(mcf_.g);
@@ -114,8 +106,7 @@ BiMCF_to_MCF::BiMCF_to_MCF(const BiMCF &_bimcf,
             }
         }
 #endif
-        double scaled_cost = bimcf_.cost[bimcf_edge] * costmul_;
-        auto cost = static_cast<MCF::CostScalar>(std::llround(scaled_cost));
+        auto cost = cost_scaling_.scale(bimcf_.cost[bimcf_edge]);
         if (mcf_u == mcf_v) {
           // special case self-loop to avoid double arcs - not necessary, just neat.
           // could be replaced by arc-combining postprocessing step.
@@ -4,6 +4,7 @@
 
 #include <libsatsuma/Problems/BiMCF.hh>
 #include <libsatsuma/Problems/MCF.hh>
+#include <libsatsuma/Problems/CostScaling.hh>
 
 namespace Satsuma {
 
@@ -25,17 +26,22 @@ public:
         Method method = Method::Default;
         std::unique_ptr<MCF::NodeMap<BiMCF::Node>> *out_orig_node = nullptr;
         std::unique_ptr<MCF::NodeMap<bool>> *out_node_is_plus = nullptr;
+        /// Costs are scaled by at most this factor, less if they are too large
+        double max_cost_multiplier = CostScaling::default_max_multiplier;
     };
     BiMCF_to_MCF(BiMCF const &_bimcf,
                  Config const &_config);
     MCF const& mcf() const {return mcf_;}
     BiMCFResult translate_solution(const MCFResult &mcf_result) const;
+    BiMCF::Edge orig_bimcf_edge(MCF::Arc a) const {return orig_bimcf_edge_[a];}
+    /// MCF costs are BiMCF costs multiplied by this factor (and rounded), see CostScaling
+    double cost_multiplier() const {return cost_scaling_.multiplier();}
 private:
     BiMCF const& bimcf_;
     Method method_;
     MCF mcf_;
     MCF::ArcMap<BiMCF::Edge> orig_bimcf_edge_{mcf_.g};
-    double costmul_ = 100;
+    CostScaling cost_scaling_;
 };
 
 } // namespace Satsuma
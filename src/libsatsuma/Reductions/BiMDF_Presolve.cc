@@ -0,0 +1,376 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Reductions/BiMDF_Presolve.hh>
+#include <libsatsuma/Exceptions.hh>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace Satsuma {
+
+namespace {
+
+using FlowScalar = BiMDF::FlowScalar;
+
+struct Part {
+    CostFunction::Function f;
+    FlowScalar lower, upper;
+};
+
+/// Integral split x = x_a + x_b within the bounds of both parts, minimizing
+/// f_a(x_a) + f_b(x_b). Binary search on the (monotone) forward difference.
+/// Returns false if no feasible split exists.
+bool split_flow(Part const &_a, Part const &_b, double _x, long &_x_a)
+{
+    double lo = _a.lower;
+    double hi = _a.upper;
+    if (_b.upper != BiMDF::inf()) {
+        lo = std::max(lo, std::ceil(_x - _b.upper));
+    }
+    hi = std::min(hi, std::floor(_x - _b.lower));
+    if (lo > hi) {
+        return false;
+    }
+    auto g = [&](long x_a) {
+        return CostFunction::cost(_a.f, x_a) + CostFunction::cost(_b.f, _x - x_a);
+    };
+    long l = static_cast<long>(lo);
+    long h = static_cast<long>(hi);
+    // find the smallest x_a with g(x_a + 1) >= g(x_a)
+    while (l < h) {
+        long mid = l + (h - l) / 2;
+        if (g(mid + 1) >= g(mid)) {
+            h = mid;
+        } else {
+            l = mid + 1;
+        }
+    }
+    _x_a = l;
+    return true;
+}
+
+/// Cost of two parallel edges with the same head flags as a function of their total flow.
+struct InfimalConvolution : public CostFunction::BaseObjective {
+    InfimalConvolution(Part _a, Part _b) : a(std::move(_a)), b(std::move(_b)) {}
+    double operator()(double x) const override {
+        long x_a = 0;
+        if (!split_flow(a, b, x, x_a)) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return CostFunction::cost(a.f, x_a) + CostFunction::cost(b.f, x - x_a);
+    }
+    double get_guess() const override {
+        // minimizer of the infimal convolution of convex functions
+        return CostFunction::get_guess(a.f) + CostFunction::get_guess(b.f);
+    }
+    Part a, b;
+};
+
+FlowScalar add_bounds(FlowScalar a, FlowScalar b)
+{
+    if (a == BiMDF::inf() || b == BiMDF::inf()) {
+        return BiMDF::inf();
+    }
+    long sum = static_cast<long>(a) + b;
+    return static_cast<FlowScalar>(std::clamp<long>(sum,
+                                                   std::numeric_limits<FlowScalar>::lowest(),
+                                                   BiMDF::inf()));
+}
+
+} // namespace
+
+BiMDF_Presolve::BiMDF_Presolve(const BiMDF &_orig)
+    : BiMDF_Presolve(_orig, Config{})
+{}
+
+BiMDF_Presolve::BiMDF_Presolve(const BiMDF &_orig, Config const &_config)
+    : orig_(_orig)
+    , residual_demand_(_orig.g)
+    , incident_(_orig.g)
+    , tightening_budget_(_config.bound_tightenings_per_edge * _orig.n_edges())
+{
+    const auto &g = orig_.g;
+    for (const auto n: g.nodes()) {
+        residual_demand_[n] = orig_.demand[n];
+    }
+    items_.reserve(2 * orig_.n_edges());
+    for (const auto e: g.edges()) {
+        const int id = static_cast<int>(items_.size());
+        items_.push_back({.u = g.u(e), .v = g.v(e),
+                          .u_head = orig_.u_head[e], .v_head = orig_.v_head[e],
+                          .lower = orig_.lower[e], .upper = orig_.upper[e],
+                          .cost_function = orig_.cost_function[e],
+                          .edge = e});
+        incident_[g.u(e)].push_back(id);
+        if (g.v(e) != g.u(e)) {
+            incident_[g.v(e)].push_back(id);
+        }
+    }
+    for (size_t i = 0; i < items_.size(); ++i) {
+        if (items_[i].lower > items_[i].upper) {
+            throw InfeasibleError("BiMDF_Presolve: edge with lower > upper bound");
+        }
+        if (items_[i].lower == items_[i].upper) {
+            fix(static_cast<int>(i), items_[i].lower);
+        }
+    }
+    for (const auto n: g.nodes()) {
+        queue_.push_back(n);
+    }
+
+    // head flag at `_n` and the other endpoint of a non-loop item
+    auto end_at = [&](Item const &it, Node _n) {
+        return it.u == _n ? std::make_tuple(it.u_head, it.v, it.v_head)
+                          : std::make_tuple(it.v_head, it.u, it.u_head);
+    };
+
+    std::map<std::tuple<int, bool, bool>, int> parallel;
+    while (!queue_.empty()) {
+        const auto n = queue_.back();
+        queue_.pop_back();
+        auto &inc = incident_[n];
+        std::erase_if(inc, [&](int i) {return !items_[i].active();});
+
+        // merge parallel items with equal head flags
+        parallel.clear();
+        bool merged = false;
+        for (const int i: inc) {
+            const auto &it = items_[i];
+            if (it.u == it.v) {
+                continue;
+            }
+            auto [head_n, other, head_other] = end_at(it, n);
+            auto [pos, inserted] = parallel.emplace(
+                        std::make_tuple(g.id(other), head_n, head_other), i);
+            if (inserted) {
+                continue;
+            }
+            const int j = pos->second;
+            const int k = static_cast<int>(items_.size());
+            Item m {.u = n, .v = other,
+                    .u_head = head_n, .v_head = head_other,
+                    .lower = add_bounds(items_[i].lower, items_[j].lower),
+                    .upper = add_bounds(items_[i].upper, items_[j].upper),
+                    .cost_function = CostFunction::VirtualObjective{
+                        std::make_shared<InfimalConvolution>(
+                            Part{items_[j].cost_function, items_[j].lower, items_[j].upper},
+                            Part{items_[i].cost_function, items_[i].lower, items_[i].upper})},
+                    .child_a = j, .child_b = i};
+            items_.push_back(std::move(m));
+            items_[i].parent = k;
+            items_[j].parent = k;
+            pos->second = k;
+            incident_[other].push_back(k);
+            queue_.push_back(other);
+            ++n_merged_;
+            merged = true;
+        }
+        if (merged) {
+            std::erase_if(inc, [&](int i) {return !items_[i].active();});
+            for (const auto &[key, k]: parallel) {
+                if (items_[k].child_a >= 0 && std::find(inc.begin(), inc.end(), k) == inc.end()) {
+                    inc.push_back(k);
+                }
+            }
+            for (const int i: inc) {
+                if (items_[i].lower == items_[i].upper) {
+                    fix(i, items_[i].lower);
+                }
+            }
+            std::erase_if(inc, [&](int i) {return !items_[i].active();});
+        }
+
+        size_t degree = 0;
+        for (const int i: inc) {
+            degree += items_[i].u == items_[i].v ? 2 : 1;
+        }
+        if (degree == 0) {
+            if (residual_demand_[n] != 0) {
+                throw InfeasibleError("BiMDF_Presolve: isolated node with non-zero demand");
+            }
+        } else if (degree == 1) {
+            const int i = inc[0];
+            bool head_n = std::get<0>(end_at(items_[i], n));
+            fix(i, head_n ? residual_demand_[n] : -residual_demand_[n]);
+        } else if (degree == 2 && inc.size() == 2 && residual_demand_[n] == 0) {
+            auto &a = items_[inc[0]];
+            auto &b = items_[inc[1]];
+            bool head_a = std::get<0>(end_at(a, n));
+            bool head_b = std::get<0>(end_at(b, n));
+            if (head_a == head_b && a.lower >= 0 && b.lower >= 0) {
+                // x_a + x_b = 0 with both non-negative
+                fix(inc[0], 0);
+                fix(inc[1], 0);
+            }
+        }
+        if (degree >= 2 && tightening_budget_ > 0) {
+            propagate_bounds(n);
+        }
+    }
+
+    NodeMap<Node> presolved_node{g, lemon::INVALID};
+    for (const auto n: g.nodes()) {
+        std::erase_if(incident_[n], [&](int i) {return !items_[i].active();});
+        if (incident_[n].empty()) {
+            if (residual_demand_[n] != 0) {
+                throw InfeasibleError("BiMDF_Presolve: isolated node with non-zero demand");
+            }
+            continue;
+        }
+        presolved_node[n] = presolved_.add_node(residual_demand_[n]);
+    }
+    for (size_t i = 0; i < items_.size(); ++i) {
+        const auto &it = items_[i];
+        if (!it.active()) {
+            continue;
+        }
+        auto e = presolved_.add_edge({.u = presolved_node[it.u], .v = presolved_node[it.v],
+                                      .u_head = it.u_head, .v_head = it.v_head,
+                                      .cost_function = it.cost_function,
+                                      .lower = it.lower, .upper = it.upper});
+        presolved_item_[e] = static_cast<int>(i);
+    }
+    if (_config.verbosity >= 2) {
+        std::cout << "presolve: " << n_fixed_ << " fixed, " << n_merged_ << " merged, "
+                  << n_tightened_ << " bounds tightened, "
+                  << presolved_.n_nodes() << " / " << orig_.n_nodes() << " nodes, "
+                  << presolved_.n_edges() << " / " << orig_.n_edges() << " edges remaining"
+                  << std::endl;
+    }
+}
+
+void BiMDF_Presolve::fix(int _item, FlowScalar _x)
+{
+    auto &it = items_[_item];
+    if (_x < it.lower || _x > it.upper) {
+        throw InfeasibleError("BiMDF_Presolve: forced flow violates edge bounds");
+    }
+    it.fixed = true;
+    it.flow = _x;
+    ++n_fixed_;
+    residual_demand_[it.u] -= it.u_head ? _x : -_x;
+    residual_demand_[it.v] -= it.v_head ? _x : -_x;
+    queue_.push_back(it.u);
+    queue_.push_back(it.v);
+}
+
+void BiMDF_Presolve::propagate_bounds(Node _n)
+{
+    // Conservation at _n: sum_i c_i x_i = demand, with c_i = +-1 for head/tail ends
+    // (self-loops: -2, 0 or 2). Each term c_i x_i lies in an interval [lo_i, hi_i],
+    // which bounds each x_j by the intervals of all other terms.
+    constexpr long inf = std::numeric_limits<long>::max() / 4;
+    auto finite_upper = [](FlowScalar upper) {return upper != BiMDF::inf();};
+    struct Term {int item; long c, lo, hi;};
+    std::vector<Term> terms;
+    long sum_lo = 0, sum_hi = 0;
+    int n_lo_inf = 0, n_hi_inf = 0;
+    for (const int i: incident_[_n]) {
+        const auto &it = items_[i];
+        if (!it.active()) {
+            continue;
+        }
+        long c = 0;
+        if (it.u == _n) c += it.u_head ? 1 : -1;
+        if (it.v == _n) c += it.v_head ? 1 : -1;
+        if (c == 0) {
+            continue;
+        }
+        const long l = it.lower;
+        const long u = finite_upper(it.upper) ? it.upper : inf;
+        Term t{.item = i, .c = c,
+               .lo = c > 0 ? c * l : (u == inf ? -inf : c * u),
+               .hi = c > 0 ? (u == inf ? inf : c * u) : c * l};
+        if (t.lo == -inf) ++n_lo_inf; else sum_lo += t.lo;
+        if (t.hi == inf) ++n_hi_inf; else sum_hi += t.hi;
+        terms.push_back(t);
+    }
+    auto floor_div = [](long a, long b) {
+        long q = a / b;
+        return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+    };
+    auto ceil_div = [&](long a, long b) {return -floor_div(-a, b);};
+
+    const long d = residual_demand_[_n];
+    for (const auto &t: terms) {
+        auto &it = items_[t.item];
+        if (!it.active() || tightening_budget_ == 0) {
+            continue;
+        }
+        // range of the sum of all other terms:
+        const bool others_lo_inf = n_lo_inf - (t.lo == -inf) > 0;
+        const bool others_hi_inf = n_hi_inf - (t.hi == inf) > 0;
+        const long others_lo = sum_lo - (t.lo == -inf ? 0 : t.lo);
+        const long others_hi = sum_hi - (t.hi == inf ? 0 : t.hi);
+        // c x in [d - others_hi, d - others_lo]
+        long new_lower = it.lower;
+        long new_upper = finite_upper(it.upper) ? it.upper : inf;
+        if (t.c > 0) {
+            if (!others_hi_inf) new_lower = std::max(new_lower, ceil_div(d - others_hi, t.c));
+            if (!others_lo_inf) new_upper = std::min(new_upper, floor_div(d - others_lo, t.c));
+        } else {
+            if (!others_lo_inf) new_lower = std::max(new_lower, ceil_div(d - others_lo, t.c));
+            if (!others_hi_inf) new_upper = std::min(new_upper, floor_div(d - others_hi, t.c));
+        }
+        if (new_lower > new_upper) {
+            throw InfeasibleError("BiMDF_Presolve: bound propagation found empty flow interval");
+        }
+        if (new_upper >= BiMDF::inf()) {
+            new_upper = finite_upper(it.upper) ? it.upper : BiMDF::inf();
+        }
+        if (new_lower == it.lower && new_upper == it.upper) {
+            continue;
+        }
+        --tightening_budget_;
+        ++n_tightened_;
+        it.lower = static_cast<FlowScalar>(new_lower);
+        it.upper = static_cast<FlowScalar>(new_upper);
+        if (it.lower == it.upper) {
+            fix(t.item, it.lower);
+        } else {
+            queue_.push_back(it.u);
+            queue_.push_back(it.v);
+        }
+    }
+}
+
+void BiMDF_Presolve::assign(int _item, FlowScalar _x, BiMDF::Solution &_sol) const
+{
+    const auto &it = items_[_item];
+    if (it.edge != lemon::INVALID) {
+        _sol[it.edge] = _x;
+        return;
+    }
+    const auto &a = items_[it.child_a];
+    const auto &b = items_[it.child_b];
+    long x_a = 0;
+    if (!split_flow({a.cost_function, a.lower, a.upper},
+                    {b.cost_function, b.lower, b.upper},
+                    _x, x_a)) {
+        throw InternalError("BiMDF_Presolve: flow of merged edge can not be split");
+    }
+    assign(it.child_a, static_cast<FlowScalar>(x_a), _sol);
+    assign(it.child_b, static_cast<FlowScalar>(_x - x_a), _sol);
+}
+
+BiMDFResult BiMDF_Presolve::translate_solution(const BiMDFResult &_presolved_result) const
+{
+    auto sol = std::make_unique<BiMDF::Solution>(orig_.g, 0);
+    for (size_t i = 0; i < items_.size(); ++i) {
+        const auto &it = items_[i];
+        if (it.parent < 0 && it.fixed) {
+            assign(static_cast<int>(i), it.flow, *sol);
+        }
+    }
+    for (const auto e: presolved_.g.edges()) {
+        assign(presolved_item_[e], (*_presolved_result.solution)[e], *sol);
+    }
+    auto cost = orig_.cost(*sol);
+    return {.solution = std::move(sol),
+            .cost = cost};
+}
+
+} // namespace Satsuma
@@ -0,0 +1,80 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <vector>
+
+namespace Satsuma {
+
+/// Structural presolve, applied until no rule applies anymore:
+///  - edges with lower == upper are fixed, their flow moves into the node demands;
+///  - the edge of a degree-1 node is fixed to the flow conservation requires;
+///  - zero-demand degree-2 nodes with two heads or two tails force both edges to zero
+///    if their lower bounds are non-negative;
+///  - parallel edges with the same head flags are merged into a single edge
+///    whose cost is the infimal convolution of their costs;
+///  - edge bounds are tightened by interval propagation over the conservation
+///    constraints, e.g. to give finite upper bounds to edges whose flow is
+///    limited by their neighbors'.
+/// Throws InfeasibleError if a rule detects infeasibility.
+class BiMDF_Presolve
+{
+public:
+    using Node = BiMDF::Node;
+    using Edge = BiMDF::Edge;
+    using FlowScalar = BiMDF::FlowScalar;
+    template<typename T> using NodeMap = BiMDF::NodeMap<T>;
+    template<typename T> using EdgeMap = BiMDF::EdgeMap<T>;
+
+    struct Config {
+        /// Limit on the number of bound tightenings, relative to the number of edges
+        /// (propagation around cycles can converge slowly), 0: no propagation.
+        size_t bound_tightenings_per_edge = 10;
+        int verbosity = 2;
+    };
+
+    BiMDF_Presolve(BiMDF const &_orig);
+    BiMDF_Presolve(BiMDF const &_orig, Config const &_config);
+    BiMDF const& bimdf() const {return presolved_;}
+    BiMDFResult translate_solution(BiMDFResult const &_presolved_result) const;
+
+    size_t n_fixed_edges() const {return n_fixed_;}
+    size_t n_merged_edges() const {return n_merged_;}
+    size_t n_tightened_bounds() const {return n_tightened_;}
+
+private:
+    /// An original edge, or two merged parallel items.
+    struct Item {
+        Node u, v;
+        bool u_head, v_head;
+        FlowScalar lower, upper;
+        CostFunction::Function cost_function;
+        Edge edge = lemon::INVALID; // leaf items only
+        int child_a = -1, child_b = -1;
+        int parent = -1;   // merged into this item
+        bool fixed = false;
+        FlowScalar flow = 0; // if fixed
+        bool active() const {return parent < 0 && !fixed;}
+    };
+
+    void fix(int _item, FlowScalar _x);
+    /// Tighten the bounds of the items incident to `_n` using its conservation constraint.
+    void propagate_bounds(Node _n);
+    /// Distribute the flow of an item to the original edges.
+    void assign(int _item, FlowScalar _x, BiMDF::Solution &_sol) const;
+
+    BiMDF const &orig_;
+    BiMDF presolved_;
+    std::vector<Item> items_;
+    NodeMap<FlowScalar> residual_demand_;
+    NodeMap<std::vector<int>> incident_;
+    std::vector<Node> queue_;
+    EdgeMap<int> presolved_item_ {presolved_.g};
+    size_t n_fixed_ = 0;
+    size_t n_merged_ = 0;
+    size_t n_tightened_ = 0;
+    size_t tightening_budget_ = 0;
+};
+
+} // namespace Satsuma
@@ -0,0 +1,107 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Reductions/BiMDF_Restriction.hh>
+#include <lemon/maps.h>
+#include <algorithm>
+#include <vector>
+
+namespace Satsuma {
+
+BiMDF_Restriction::BiMDF_Restriction(const BiMDF &_orig,
+                                     const EdgeMap<bool> &_active,
+                                     const BiMDF::Solution &_fixed)
+    : orig_(_orig)
+    , fixed_(_fixed)
+{
+    std::vector<Edge> edges;
+    for (const auto e: _orig.g.edges()) {
+        if (_active[e]) {
+            edges.push_back(e);
+        }
+    }
+    init(edges, [&](Edge e){return _active[e];});
+}
+
+BiMDF_Restriction::BiMDF_Restriction(const BiMDF &_orig,
+                                     std::span<const Edge> _edges,
+                                     std::function<bool(Edge)> const &_is_active,
+                                     const BiMDF::Solution &_fixed)
+    : orig_(_orig)
+    , fixed_(_fixed)
+{
+    init(_edges, _is_active);
+}
+
+void BiMDF_Restriction::init(std::span<const Edge> _edges,
+                             std::function<bool(Edge)> const &_is_active)
+{
+    const auto &g = orig_.g;
+    // sub nodes are created in order of first appearance; a sorted vector
+    // avoids allocating a map on the (possibly much larger) original graph.
+    std::vector<std::pair<int, Node>> sub_node; // (orig node id, sub node)
+    sub_node.reserve(2 * _edges.size());
+    std::vector<Node> orig_nodes;
+    for (const auto e: _edges) {
+        orig_nodes.push_back(g.u(e));
+        orig_nodes.push_back(g.v(e));
+    }
+    std::sort(orig_nodes.begin(), orig_nodes.end(),
+              [&](Node a, Node b){return g.id(a) < g.id(b);});
+    orig_nodes.erase(std::unique(orig_nodes.begin(), orig_nodes.end()), orig_nodes.end());
+
+    for (const auto n: orig_nodes) {
+        auto demand = orig_.demand[n];
+        // move fixed flow of inactive incident edges into the demand:
+        for (const auto a: g.outArcs(n)) {
+            const Edge e = a;
+            if (_is_active(e)) {
+                continue;
+            }
+            bool head = g.direction(a) ? orig_.u_head[e] : orig_.v_head[e];
+            demand -= head ? fixed_[e] : -fixed_[e];
+        }
+        sub_node.emplace_back(g.id(n), sub_.add_node(demand));
+    }
+    auto get_sub_node = [&](Node n) {
+        auto it = std::lower_bound(sub_node.begin(), sub_node.end(), g.id(n),
+                                   [](auto const &p, int id){return p.first < id;});
+        return it->second;
+    };
+    for (const auto e: _edges) {
+        auto ei = orig_.get_edge_info(e);
+        ei.u = get_sub_node(ei.u);
+        ei.v = get_sub_node(ei.v);
+        auto sub_e = sub_.add_edge(ei);
+        orig_edge_[sub_e] = e;
+    }
+}
+
+std::unique_ptr<BiMDF::Solution>
+BiMDF_Restriction::restrict_solution(const BiMDF::Solution &_orig_sol) const
+{
+    auto sub_sol = std::make_unique<BiMDF::Solution>(sub_.g);
+    for (const auto e: sub_.g.edges()) {
+        (*sub_sol)[e] = _orig_sol[orig_edge_[e]];
+    }
+    return sub_sol;
+}
+
+void BiMDF_Restriction::apply_solution(const BiMDF::Solution &_sub_sol,
+                                       BiMDF::Solution &_orig_sol) const
+{
+    for (const auto e: sub_.g.edges()) {
+        _orig_sol[orig_edge_[e]] = _sub_sol[e];
+    }
+}
+
+BiMDFResult BiMDF_Restriction::translate_solution(const BiMDFResult &_sub_result) const
+{
+    auto orig_sol = std::make_unique<BiMDF::Solution>(orig_.g);
+    lemon::mapCopy(orig_.g, fixed_, *orig_sol);
+    apply_solution(*_sub_result.solution, *orig_sol);
+    auto cost = orig_.cost(*orig_sol);
+    return {.solution = std::move(orig_sol),
+            .cost = cost};
+}
+
+} // namespace Satsuma
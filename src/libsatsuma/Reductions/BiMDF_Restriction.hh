@@ -0,0 +1,58 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <functional>
+#include <span>
+
+namespace Satsuma {
+
+/// Restrict a BiMDF problem to a subset of "active" edges.
+/// All inactive edges keep their flow from `_fixed`, their contribution is moved
+/// into the node demands of the restricted problem.
+/// Only nodes incident to active edges are part of the restricted problem.
+///
+/// `_fixed` must outlive this object.
+class BiMDF_Restriction
+{
+public:
+    using Node = BiMDF::Node;
+    using Edge = BiMDF::Edge;
+    template<typename T> using NodeMap = BiMDF::NodeMap<T>;
+    template<typename T> using EdgeMap = BiMDF::EdgeMap<T>;
+
+    BiMDF_Restriction(BiMDF const &_orig,
+                      EdgeMap<bool> const &_active,
+                      BiMDF::Solution const &_fixed);
+
+    /// Restriction to `_edges`, `_is_active(e)` must be true exactly for those edges.
+    /// Runs in time linear in the size of the neighborhood of `_edges`,
+    /// so many small restrictions of a large problem are cheap to build.
+    BiMDF_Restriction(BiMDF const &_orig,
+                      std::span<const Edge> _edges,
+                      std::function<bool(Edge)> const &_is_active,
+                      BiMDF::Solution const &_fixed);
+
+    BiMDF const& bimdf() const {return sub_;}
+
+    /// Restrict a solution of the original problem to the active edges, e.g. to use it as guess.
+    std::unique_ptr<BiMDF::Solution> restrict_solution(BiMDF::Solution const &_orig_sol) const;
+
+    /// Combine a solution of the restricted problem with the fixed flows of all inactive edges.
+    BiMDFResult translate_solution(BiMDFResult const &_sub_result) const;
+
+    /// Write the flows of a solution of the restricted problem into the active edges of `_orig_sol`.
+    void apply_solution(BiMDF::Solution const &_sub_sol, BiMDF::Solution &_orig_sol) const;
+
+private:
+    void init(std::span<const Edge> _edges,
+              std::function<bool(Edge)> const &_is_active);
+
+    BiMDF const &orig_;
+    BiMDF::Solution const &fixed_;
+    BiMDF sub_;
+    EdgeMap<Edge> orig_edge_ {sub_.g};
+};
+
+} // namespace Satsuma
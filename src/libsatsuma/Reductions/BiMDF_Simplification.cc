@@ -1,135 +1,263 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Reductions/BiMDF_Simplification.hh>
+#include <libsatsuma/Extra/Parallel.hh>
 #include <lemon/connectivity.h>
+#include <lemon/maps.h>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 namespace Satsuma {
 
-BiMDF_Simplification::BiMDF_Simplification(const BiMDF &_orig)
-    : orig_{_orig}
-    , simp_edge_{_orig.g}
+namespace {
+
+/// Number of chunks to split `n` items into for `n_threads` threads (0: all hardware threads).
+size_t chunk_count(int n, unsigned n_threads)
 {
+    if (n_threads == 1 || n < 1024) {
+        return 1;
+    }
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::min<size_t>(4 * n_threads, (n + 1023) / 1024);
+}
 
-    BiMDF::NodeMap<bool> collapse_node{_orig.g, false};
-    BiMDF::EdgeMap<bool> collapse_edge{_orig.g, false};
+std::pair<int, int> chunk_range(size_t chunk, int n, unsigned n_threads)
+{
+    const size_t n_chunks = chunk_count(n, n_threads);
+    return {static_cast<int>(chunk * n / n_chunks),
+            static_cast<int>((chunk + 1) * n / n_chunks)};
+}
 
-    size_t n_collapse_nodes = 0;
-    for (const auto n: _orig.g.nodes()) {
-        if (_orig.demand[n] != 0) {
-            continue;
+/// Label connected components with a concurrent union-find over the edges.
+/// Components are numbered in order of their first node in `g.nodes()`,
+/// like lemon::connectedComponents does.
+size_t parallel_connected_components(BiMDF::GraphT const &g,
+                                     BiMDF::NodeMap<size_t> &comp,
+                                     unsigned n_threads)
+{
+    const int n_node_ids = g.maxNodeId() + 1;
+    const int n_edge_ids = g.maxEdgeId() + 1;
+    std::vector<std::atomic<int>> parent(n_node_ids);
+    for (int i = 0; i < n_node_ids; ++i) {
+        parent[i].store(i, std::memory_order_relaxed);
+    }
+    auto find = [&](int x) {
+        while (true) {
+            int p = parent[x].load(std::memory_order_relaxed);
+            if (p == x) {
+                return x;
+            }
+            int gp = parent[p].load(std::memory_order_relaxed);
+            // path halving; roots only ever get linked to smaller ids, so this is safe
+            parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            x = gp;
         }
-        bool have_one_head = false;
-        bool have_one_tail = false;
-
-        for([[maybe_unused]] const auto e: _orig.g.outArcs(n)) {
-            bool is_head = (n == _orig.g.u(e)) ? _orig.u_head[e] : _orig.v_head[e];
-            if (is_head) {
-                if (have_one_head) {
-                    // more than one head
-                    have_one_head = false;
+    };
+    parallel_for(chunk_count(n_edge_ids, n_threads), n_threads, [&](size_t chunk) {
+        auto [begin, end] = chunk_range(chunk, n_edge_ids, n_threads);
+        for (int id = begin; id < end; ++id) {
+            const auto e = g.edgeFromId(id);
+            if (!g.valid(e)) {
+                continue;
+            }
+            int a = g.id(g.u(e));
+            int b = g.id(g.v(e));
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b) {
                     break;
                 }
-                have_one_head = true;
-            } else {
-                if (have_one_tail) {
-                    // more than one tail
-                    have_one_tail = false;
+                if (a < b) {
+                    std::swap(a, b);
+                }
+                // link root a below the smaller root b
+                int expected = a;
+                if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) {
                     break;
                 }
-                have_one_tail = true;
             }
         }
-        if (have_one_head && have_one_tail) {
-            ++n_collapse_nodes;
-            collapse_node[n] = true;
-            for(const auto e: _orig.g.outArcs(n)) {
-                collapse_edge[e] = true;
-            }
+    });
+    std::vector<size_t> root_comp(n_node_ids, std::numeric_limits<size_t>::max());
+    size_t n_comp = 0;
+    for (const auto n: g.nodes()) {
+        auto &c = root_comp[find(g.id(n))];
+        if (c == std::numeric_limits<size_t>::max()) {
+            c = n_comp++;
         }
+        comp[n] = c;
     }
-    std::cout << "# collapsible nodes:" << n_collapse_nodes
-              << " / " << _orig.g.maxNodeId() + 1
-              << std::endl;
+    return n_comp;
+}
+
+} // namespace
 
-    if (n_collapse_nodes == static_cast<size_t>(_orig.g.maxEdgeId() + 1)) {
-        std::cout << "graph is collapsible cycle, preventing collapse for an arbitrary node." << std::endl;
-        collapse_node[_orig.g.nodeFromId(_orig.g.maxNodeId())] = false;
+BiMDF_Simplification::BiMDF_Simplification(const BiMDF &_orig, int _verbosity, unsigned _threads)
+    : orig_{_orig}
+    , simp_edge_{_orig.g}
+{
+    const auto &g = _orig.g;
+    const int n_node_ids = g.maxNodeId() + 1;
+
+    // char instead of bool: written concurrently
+    std::vector<char> collapse_node(n_node_ids, false);
+    parallel_for(chunk_count(n_node_ids, _threads), _threads, [&](size_t chunk) {
+        auto [begin, end] = chunk_range(chunk, n_node_ids, _threads);
+        for (int id = begin; id < end; ++id) {
+            const auto n = g.nodeFromId(id);
+            if (!g.valid(n) || _orig.demand[n] != 0) {
+                continue;
+            }
+            bool have_one_head = false;
+            bool have_one_tail = false;
+
+            for (const auto e: g.outArcs(n)) {
+                bool is_head = (n == g.u(e)) ? _orig.u_head[e] : _orig.v_head[e];
+                if (is_head) {
+                    if (have_one_head) {
+                        // more than one head
+                        have_one_head = false;
+                        break;
+                    }
+                    have_one_head = true;
+                } else {
+                    if (have_one_tail) {
+                        // more than one tail
+                        have_one_tail = false;
+                        break;
+                    }
+                    have_one_tail = true;
+                }
+            }
+            collapse_node[id] = have_one_head && have_one_tail;
+        }
+    });
+    auto collapsible = [&](Node n) {return collapse_node[g.id(n)] != 0;};
+
+    if (_verbosity >= 2) {
+        std::cout << "# collapsible nodes:"
+                  << std::count(collapse_node.begin(), collapse_node.end(), true)
+                  << " / " << n_node_ids
+                  << std::endl;
     }
 
-    auto simp_node = NodeMap<Node>{_orig.g, lemon::INVALID};
-    for (const auto n: _orig.g.nodes()) {
-        if (!collapse_node[n]) {
+    // A cycle consisting only of collapsible nodes (e.g. a whole component)
+    // has no chain end; keep one node of each such cycle.
+    {
+        std::vector<char> visited(n_node_ids, false);
+        for (const auto start: g.nodes()) {
+            if (!collapsible(start) || visited[g.id(start)]) {
+                continue;
+            }
+            // walk along the chain in one direction
+            auto n = start;
+            Edge prev = lemon::INVALID;
+            while (collapsible(n) && !visited[g.id(n)]) {
+                visited[g.id(n)] = true;
+                for (const auto a: g.outArcs(n)) {
+                    if (Edge(a) != prev) {
+                        prev = a;
+                        n = g.target(a);
+                        break;
+                    }
+                }
+            }
+            if (n == start) {
+                if (_verbosity >= 2) {
+                    std::cout << "found collapsible cycle, preventing collapse for one of its nodes." << std::endl;
+                }
+                collapse_node[g.id(start)] = false;
+            }
+        }
+    }
 
-            simp_node[n] = simp_.g.addNode();
+    auto simp_node = NodeMap<Node>{g, lemon::INVALID};
+    for (const auto n: g.nodes()) {
+        if (!collapsible(n)) {
+            simp_node[n] = simp_.add_node(_orig.demand[n]);
         }
     }
 
-    BiMDF::EdgeMap<bool> edge_added{_orig.g, false};
-    std::vector<Edge> chain;
-    std::vector<CostFunction::Function> chain_costs;
-    auto extend_chain = [&](Edge _e, Node _n) -> std::pair<Node, bool> {
-        const auto &g = _orig.g;
-        Edge cur_e = _e;
-        Node cur_n = _n;
-        //std::cout << "extend_chain(e = " << g.id(_e) << ", n = " << g.id(_n) << ")" << std::endl;
-        while (collapse_node[cur_n]) {
-            //std::cout << "\tcur_e = " << g.id(cur_e) << ", cur_n = " << g.id(cur_n) << std::endl;
-            for(const auto &other_a: g.outArcs(cur_n)) {
-                //std::cout << "\t\tother_e = " << g.id(other_a) << std::endl;
-                if (Edge(other_a) == cur_e) {
+    // Every chain of collapsible nodes connects two arcs leaving non-collapsible nodes.
+    // Walk each chain from both ends in parallel, the end with the smaller arc id
+    // records it. Chains are then added in a deterministic order.
+    struct Chain {
+        BiMDF::EdgeInfo ei;
+        std::vector<Edge> edges;
+    };
+    const size_t n_chunks = chunk_count(n_node_ids, _threads);
+    std::vector<std::vector<Chain>> chains(n_chunks);
+    parallel_for(n_chunks, _threads, [&](size_t chunk) {
+        std::vector<CostFunction::Function> chain_costs;
+        auto [begin, end] = chunk_range(chunk, n_node_ids, _threads);
+        for (int id = begin; id < end; ++id) {
+            const auto n = g.nodeFromId(id);
+            if (!g.valid(n) || collapsible(n)) {
+                continue;
+            }
+            for (const auto a: g.outArcs(n)) {
+                if (!collapsible(g.target(a))) {
                     continue;
-                } else {
-                    chain.push_back(other_a);
-                    const auto other_u = g.u(other_a);
-                    const auto other_v = g.v(other_a);
-                    //std::cout << "\t\t\tother_u = " << g.id(other_u) << std::endl;
-                    //std::cout << "\t\t\tother_v = " << g.id(other_v) << std::endl;
-                    assert(other_u == cur_n || other_v == cur_n);
-                    cur_n = (cur_n == other_u) ? other_v : other_u;
-
-                    cur_e = other_a;
-                    if(edge_added[cur_e]) {
-                        throw std::runtime_error("this should not happen, found edge twice");
+                }
+                Chain chain;
+                chain.edges.push_back(a);
+                auto last = a;
+                auto cur_n = g.target(a);
+                while (collapsible(cur_n)) {
+                    for (const auto other_a: g.outArcs(cur_n)) {
+                        if (Edge(other_a) != Edge(last)) {
+                            last = other_a;
+                            break;
+                        }
                     }
-                    edge_added[cur_e] = true;
-                    break; // disable for debug
+                    chain.edges.push_back(last);
+                    cur_n = g.target(last);
+                }
+                const auto end_arc = g.oppositeArc(last);
+                if (g.id(end_arc) < g.id(a)) {
+                    continue; // recorded from the other end
+                }
+                auto head_at = [&](Edge e, Node at) {
+                    return g.u(e) == at ? _orig.u_head[e] : _orig.v_head[e];
+                };
+                chain.ei = {.u = n, .v = cur_n,
+                            .u_head = head_at(a, n), .v_head = head_at(last, cur_n),
+                            .lower = _orig.lower[chain.edges[0]],
+                            .upper = _orig.upper[chain.edges[0]]};
+                chain_costs.clear();
+                for (const auto chain_e: chain.edges) {
+                    chain.ei.lower = std::max(chain.ei.lower, _orig.lower[chain_e]);
+                    chain.ei.upper = std::min(chain.ei.upper, _orig.upper[chain_e]);
+                    chain_costs.push_back(_orig.cost_function[chain_e]);
                 }
+                chain.ei.cost_function = CostFunction::Sum(chain_costs.begin(), chain_costs.end());
+                chains[chunk].push_back(std::move(chain));
             }
         }
-        bool head = g.u(cur_e) == cur_n ? _orig.u_head[cur_e] : _orig.v_head[cur_e];
-        return {cur_n, head};
-    };
+    });
 
-    for (const auto e: _orig.g.edges()) {
-        if (edge_added[e]) continue;
-        if (!collapse_edge[e]) {
+    for (const auto e: g.edges()) {
+        if (!collapsible(g.u(e)) && !collapsible(g.v(e))) {
             BiMDF::EdgeInfo ei = _orig.get_edge_info(e);
             ei.u = simp_node[ei.u];
             ei.v = simp_node[ei.v];
             simp_edge_[e] = simp_.add_edge(ei);
-        } else {
-            chain.clear();
-            chain_costs.clear();
-            chain.push_back(e);
-            auto [u, u_head] = extend_chain(e, _orig.g.u(e));
-            auto [v, v_head] = extend_chain(e, _orig.g.v(e));
-            auto ei = BiMDF::EdgeInfo{
-                    .u = simp_node[u], .v = simp_node[v],
-                    .u_head = u_head, .v_head = v_head};
-            if (ei.u == lemon::INVALID || ei.v == lemon::INVALID) {
-                throw std::runtime_error("something wrong with extend_chain, end node not in new problem");
-            }
-            ei.lower = _orig.lower[e];
-            ei.upper = _orig.upper[e];
-            for (const auto chain_e: chain) {
-                ei.lower = std::max(ei.lower, _orig.lower[chain_e]);
-                ei.upper = std::min(ei.upper, _orig.upper[chain_e]);
-                chain_costs.push_back(_orig.cost_function[chain_e]);
-            }
-            ei.cost_function = CostFunction::Sum(chain_costs.begin(), chain_costs.end());
-            auto simp_e  = simp_.add_edge(ei);
-            for (const auto chain_e: chain) {
+        }
+    }
+    for (auto &chunk_chains: chains) {
+        for (auto &chain: chunk_chains) {
+            chain.ei.u = simp_node[chain.ei.u];
+            chain.ei.v = simp_node[chain.ei.v];
+            auto simp_e = simp_.add_edge(chain.ei);
+            for (const auto chain_e: chain.edges) {
                 simp_edge_[chain_e] = simp_e;
             }
         }
@@ -149,30 +277,432 @@ BiMDFResult BiMDF_Simplification::translate_solution(const BiMDFResult &_simp_re
 }
 
 BiMDF_ConnectedComponents::BiMDF_ConnectedComponents(const BiMDF &_orig)
+    : BiMDF_ConnectedComponents(_orig, Config{})
+{}
+
+BiMDF_ConnectedComponents::BiMDF_ConnectedComponents(const BiMDF &_orig,
+                                                     Config const &_config)
     : orig_(_orig)
     , node_cc_(_orig.g)
     , sub_node_(_orig.g)
     , sub_edge_(_orig.g)
 {
-    n_cc_ = lemon::connectedComponents(_orig.g, node_cc_);
-    std::cout << "#CC: " << n_cc_ << std::endl;
-    bimdfs_ = std::make_unique<BiMDF[]>(n_cc_);
-    for (const auto n: _orig.g.nodes()) {
-        auto cc = node_cc_[n];
-        sub_node_[n] = bimdfs_[cc].add_node(_orig.demand[n]);
-    }
-    for (const auto e: _orig.g.edges()) {
-        auto ei = _orig.get_edge_info(e);
-        auto u_cc = node_cc_[ei.u];
-        assert(u_cc == node_cc_[ei.v]);
-        ei.u = sub_node_[ei.u];
-        ei.v = sub_node_[ei.v];
-        sub_edge_[e] =  bimdfs_[u_cc].add_edge(ei);
-
+    const size_t n_raw_cc = _config.threads == 1
+        ? lemon::connectedComponents(_orig.g, node_cc_)
+        : parallel_connected_components(_orig.g, node_cc_, _config.threads);
+    n_cc_ = n_raw_cc;
+    n_components_.assign(n_cc_, 1);
+    if (_config.pack_below_edges > 0) {
+        std::vector<size_t> cc_nodes(n_raw_cc, 0);
+        std::vector<size_t> cc_edges(n_raw_cc, 0);
+        for (const auto n: _orig.g.nodes()) {
+            ++cc_nodes[node_cc_[n]];
+        }
+        for (const auto e: _orig.g.edges()) {
+            ++cc_edges[node_cc_[_orig.g.u(e)]];
+        }
+        auto pack = [&](size_t cc) {
+            // trees and unicyclic components: cyclomatic number m - n + 1 <= 1
+            bool low_cyclomatic = cc_edges[cc] <= cc_nodes[cc];
+            return cc_edges[cc] < _config.pack_below_edges
+                && (_config.pack_low_cyclomatic || !low_cyclomatic);
+        };
+        // renumber: regular components first, then one packed sub-problem
+        std::vector<size_t> new_id(n_raw_cc);
+        size_t n_regular = 0;
+        size_t n_packed = 0;
+        for (size_t cc = 0; cc < n_raw_cc; ++cc) {
+            if (pack(cc)) {
+                ++n_packed;
+            } else {
+                new_id[cc] = n_regular++;
+            }
+        }
+        if (n_packed > 1) {
+            for (size_t cc = 0; cc < n_raw_cc; ++cc) {
+                if (pack(cc)) {
+                    new_id[cc] = n_regular;
+                }
+            }
+            for (const auto n: _orig.g.nodes()) {
+                node_cc_[n] = new_id[node_cc_[n]];
+            }
+            n_cc_ = n_regular + 1;
+            n_components_.assign(n_cc_, 1);
+            n_components_.back() = n_packed;
+        }
+    }
+    if (_config.verbosity >= 2) {
+        std::cout << "#CC: " << n_raw_cc;
+        if (n_cc_ != n_raw_cc) {
+            std::cout << ", packed into " << n_cc_ << " sub-problems";
+        }
+        std::cout << std::endl;
+    }
+    if (n_cc_ <= 1) {
+        // a single (possibly packed) sub-problem is the original problem itself
+        views_.assign(n_cc_, &orig_);
+    } else {
+        std::vector<int> cc_nodes(n_cc_, 0);
+        std::vector<int> cc_edges(n_cc_, 0);
+        for (const auto n: _orig.g.nodes()) {
+            ++cc_nodes[node_cc_[n]];
+        }
+        for (const auto e: _orig.g.edges()) {
+            ++cc_edges[node_cc_[_orig.g.u(e)]];
+        }
+        bimdfs_ = std::make_unique<BiMDF[]>(n_cc_);
+        for (size_t cc = 0; cc < n_cc_; ++cc) {
+            bimdfs_[cc].g.reserveNode(cc_nodes[cc]);
+            bimdfs_[cc].g.reserveEdge(cc_edges[cc]);
+            views_.push_back(&bimdfs_[cc]);
+        }
+        for (const auto n: _orig.g.nodes()) {
+            auto cc = node_cc_[n];
+            sub_node_[n] = bimdfs_[cc].add_node(_orig.demand[n]);
+        }
+        for (const auto e: _orig.g.edges()) {
+            auto ei = _orig.get_edge_info(e);
+            auto u_cc = node_cc_[ei.u];
+            assert(u_cc == node_cc_[ei.v]);
+            ei.u = sub_node_[ei.u];
+            ei.v = sub_node_[ei.v];
+            sub_edge_[e] =  bimdfs_[u_cc].add_edge(ei);
+        }
+    }
+    representative_.resize(n_cc_);
+    for (size_t i = 0; i < n_cc_; ++i) {
+        representative_[i] = i;
+    }
+    rep_edge_.resize(n_cc_);
+    if (_config.deduplicate) {
+        deduplicate();
+        if (_config.verbosity >= 2) {
+            size_t n_unique = 0;
+            for (size_t i = 0; i < n_cc_; ++i) {
+                n_unique += representative_[i] == i;
+            }
+            std::cout << "#CC: " << n_unique << " distinct sub-problems" << std::endl;
+        }
     }
     return;
 }
 
+namespace {
+
+void hash_combine(size_t &seed, size_t v) {
+    seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+/// Isomorphism test between connected sub-problems, guided by
+/// Weisfeiler-Lehman node colors. Each arc is labeled by an edge type
+/// (bounds and cost function) and the head flags at both of its ends.
+class ComponentMatcher
+{
+public:
+    using Node = BiMDF::Node;
+    using Edge = BiMDF::Edge;
+    using Arc = BiMDF::Arc;
+
+    /// Upper bound on the number of tentative node assignments per test,
+    /// relative to the component size; on exhaustion the test fails (conservatively).
+    static constexpr size_t budget_factor = 8;
+
+    ComponentMatcher(BiMDF const &_bimdf, std::vector<size_t> const &_edge_type)
+        : bimdf_(_bimdf)
+        , edge_type_(_edge_type)
+        , color_(_bimdf.g.maxNodeId() + 1)
+    {
+        const auto &g = bimdf_.g;
+        for (const auto n: g.nodes()) {
+            auto h = std::hash<int>{}(bimdf_.demand[n]);
+            std::vector<size_t> sigs;
+            for (const auto a: g.outArcs(n)) {
+                sigs.push_back(signature(a));
+            }
+            std::sort(sigs.begin(), sigs.end());
+            for (const auto sig: sigs) {
+                hash_combine(h, sig);
+            }
+            color_[g.id(n)] = h;
+        }
+        std::vector<std::pair<size_t, size_t>> nbs;
+        for (int round = 0; round < 3; ++round) {
+            auto next = color_;
+            for (const auto n: g.nodes()) {
+                nbs.clear();
+                for (const auto a: g.outArcs(n)) {
+                    nbs.emplace_back(signature(a), color_[g.id(g.target(a))]);
+                }
+                std::sort(nbs.begin(), nbs.end());
+                auto &h = next[g.id(n)];
+                for (const auto &[sig, col]: nbs) {
+                    hash_combine(h, sig);
+                    hash_combine(h, col);
+                }
+            }
+            color_ = std::move(next);
+        }
+        std::vector<size_t> sorted_colors(color_);
+        std::sort(sorted_colors.begin(), sorted_colors.end());
+        hash_ = bimdf_.n_nodes();
+        hash_combine(hash_, bimdf_.n_edges());
+        for (const auto c: sorted_colors) {
+            hash_combine(hash_, c);
+        }
+    }
+
+    size_t hash() const {return hash_;}
+
+    /// Find an isomorphism from `_other` to this component.
+    /// On success, return the corresponding edge of this component for each edge id of `_other`.
+    std::vector<Edge> match(ComponentMatcher const &_other) const
+    {
+        const auto &ga = bimdf_.g;
+        const auto &gb = _other.bimdf_.g;
+        if (hash_ != _other.hash_
+                || bimdf_.n_nodes() != _other.bimdf_.n_nodes()
+                || bimdf_.n_edges() != _other.bimdf_.n_edges()) {
+            return {};
+        }
+        const size_t n_nodes = bimdf_.n_nodes();
+
+        // Visit our nodes in BFS order from a node of the rarest color.
+        std::unordered_map<size_t, size_t> color_count;
+        for (const auto n: ga.nodes()) {
+            ++color_count[color_[ga.id(n)]];
+        }
+        Node start = lemon::INVALID;
+        for (const auto n: ga.nodes()) {
+            if (start == lemon::INVALID
+                    || color_count[color_[ga.id(n)]] < color_count[color_[ga.id(start)]]) {
+                start = n;
+            }
+        }
+        std::vector<Node> order{start};
+        std::vector<Node> parent{lemon::INVALID};
+        std::vector<bool> seen(ga.maxNodeId() + 1, false);
+        seen[ga.id(start)] = true;
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (const auto a: ga.outArcs(order[i])) {
+                auto t = ga.target(a);
+                if (!seen[ga.id(t)]) {
+                    seen[ga.id(t)] = true;
+                    order.push_back(t);
+                    parent.push_back(order[i]);
+                }
+            }
+        }
+        if (order.size() != n_nodes) {
+            return {}; // not connected
+        }
+
+        std::vector<Node> img(ga.maxNodeId() + 1, lemon::INVALID); // our node -> other node
+        std::vector<bool> used(gb.maxNodeId() + 1, false);
+        std::vector<std::vector<Node>> candidates(n_nodes);
+        std::vector<size_t> next_candidate(n_nodes, 0);
+
+        auto collect_candidates = [&](size_t k) {
+            auto &cands = candidates[k];
+            cands.clear();
+            next_candidate[k] = 0;
+            const auto col = color_[ga.id(order[k])];
+            auto consider = [&](Node y) {
+                if (!used[gb.id(y)] && _other.color_[gb.id(y)] == col
+                        && std::find(cands.begin(), cands.end(), y) == cands.end()) {
+                    cands.push_back(y);
+                }
+            };
+            if (k == 0) {
+                for (const auto y: gb.nodes()) {
+                    consider(y);
+                }
+            } else {
+                for (const auto b: gb.outArcs(img[ga.id(parent[k])])) {
+                    consider(gb.target(b));
+                }
+            }
+        };
+        // arcs between x and already mapped nodes must correspond to those between y and their images
+        std::vector<std::pair<size_t, int>> arcs_a, arcs_b;
+        auto consistent = [&](Node x, Node y) {
+            arcs_a.clear();
+            arcs_b.clear();
+            for (const auto a: ga.outArcs(x)) {
+                auto t = ga.target(a);
+                if (t == x) {
+                    arcs_a.emplace_back(signature(a), gb.id(y));
+                } else if (img[ga.id(t)] != lemon::INVALID) {
+                    arcs_a.emplace_back(signature(a), gb.id(img[ga.id(t)]));
+                }
+            }
+            for (const auto b: gb.outArcs(y)) {
+                auto t = gb.target(b);
+                if (t == y || used[gb.id(t)]) {
+                    arcs_b.emplace_back(_other.signature(b), gb.id(t));
+                }
+            }
+            std::sort(arcs_a.begin(), arcs_a.end());
+            std::sort(arcs_b.begin(), arcs_b.end());
+            return arcs_a == arcs_b;
+        };
+
+        size_t budget = budget_factor * (n_nodes + bimdf_.n_edges()) + 100;
+        size_t k = 0;
+        collect_candidates(0);
+        while (true) {
+            if (k == n_nodes) {
+                break;
+            }
+            auto &cands = candidates[k];
+            const auto x = order[k];
+            bool assigned = false;
+            while (next_candidate[k] < cands.size()) {
+                if (budget-- == 0) {
+                    return {};
+                }
+                auto y = cands[next_candidate[k]++];
+                if (consistent(x, y)) {
+                    img[ga.id(x)] = y;
+                    used[gb.id(y)] = true;
+                    assigned = true;
+                    break;
+                }
+            }
+            if (assigned) {
+                ++k;
+                if (k < n_nodes) {
+                    collect_candidates(k);
+                }
+                continue;
+            }
+            // backtrack
+            if (k == 0) {
+                return {};
+            }
+            --k;
+            used[gb.id(img[ga.id(order[k])])] = false;
+            img[ga.id(order[k])] = lemon::INVALID;
+        }
+
+        // Pair up edges by their (normalized) endpoints in `_other` and labels.
+        using Key = std::tuple<int, int, bool, bool, size_t>;
+        auto key = [](int u, int v, bool u_head, bool v_head, size_t type) {
+            if (u > v || (u == v && u_head > v_head)) {
+                std::swap(u, v);
+                std::swap(u_head, v_head);
+            }
+            return Key{u, v, u_head, v_head, type};
+        };
+        std::vector<std::pair<Key, Edge>> edges_a, edges_b;
+        for (const auto e: ga.edges()) {
+            edges_a.emplace_back(key(gb.id(img[ga.id(ga.u(e))]), gb.id(img[ga.id(ga.v(e))]),
+                                     bimdf_.u_head[e], bimdf_.v_head[e],
+                                     edge_type_[ga.id(e)]),
+                                 e);
+        }
+        for (const auto e: gb.edges()) {
+            edges_b.emplace_back(key(gb.id(gb.u(e)), gb.id(gb.v(e)),
+                                     _other.bimdf_.u_head[e], _other.bimdf_.v_head[e],
+                                     _other.edge_type_[gb.id(e)]),
+                                 e);
+        }
+        auto by_key = [](auto const &p, auto const &q) {return p.first < q.first;};
+        std::sort(edges_a.begin(), edges_a.end(), by_key);
+        std::sort(edges_b.begin(), edges_b.end(), by_key);
+        std::vector<Edge> result(gb.maxEdgeId() + 1, lemon::INVALID);
+        for (size_t i = 0; i < edges_a.size(); ++i) {
+            if (edges_a[i].first != edges_b[i].first) {
+                return {}; // should not happen after the consistency checks
+            }
+            result[gb.id(edges_b[i].second)] = edges_a[i].second;
+        }
+        return result;
+    }
+
+private:
+    size_t signature(Arc a) const {
+        const auto &g = bimdf_.g;
+        const Edge e = a;
+        bool head_here = g.direction(a) ? bimdf_.u_head[e] : bimdf_.v_head[e];
+        bool head_there = g.direction(a) ? bimdf_.v_head[e] : bimdf_.u_head[e];
+        return 4 * edge_type_[g.id(e)] + 2 * head_here + head_there;
+    }
+
+    BiMDF const &bimdf_;
+    std::vector<size_t> const &edge_type_;
+    std::vector<size_t> color_;
+    size_t hash_ = 0;
+};
+
+} // namespace
+
+void BiMDF_ConnectedComponents::deduplicate()
+{
+    // Number edge types (bounds and cost function) consistently across all sub-problems.
+    std::vector<std::vector<size_t>> edge_type(n_cc_);
+    std::unordered_map<size_t, std::vector<std::pair<BiMDF::EdgeInfo, size_t>>> types;
+    size_t n_types = 0;
+    for (size_t i = 0; i < n_cc_; ++i) {
+        const auto &sub = *views_[i];
+        edge_type[i].resize(sub.g.maxEdgeId() + 1);
+        for (const auto e: sub.g.edges()) {
+            auto ei = sub.get_edge_info(e);
+            size_t h = CostFunction::hash(ei.cost_function);
+            hash_combine(h, std::hash<int>{}(ei.lower));
+            hash_combine(h, std::hash<int>{}(ei.upper));
+            auto &bucket = types[h];
+            auto it = std::find_if(bucket.begin(), bucket.end(), [&](auto const &p) {
+                return p.first.lower == ei.lower && p.first.upper == ei.upper
+                    && CostFunction::equal(p.first.cost_function, ei.cost_function);
+            });
+            if (it == bucket.end()) {
+                bucket.emplace_back(ei, n_types);
+                edge_type[i][sub.g.id(e)] = n_types++;
+            } else {
+                edge_type[i][sub.g.id(e)] = it->second;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<ComponentMatcher>> matchers(n_cc_);
+    std::unordered_map<size_t, std::vector<size_t>> reps_by_hash;
+    for (size_t i = 0; i < n_cc_; ++i) {
+        if (n_components_[i] != 1) {
+            continue;
+        }
+        matchers[i] = std::make_unique<ComponentMatcher>(*views_[i], edge_type[i]);
+        auto &reps = reps_by_hash[matchers[i]->hash()];
+        for (const auto r: reps) {
+            auto edge_map = matchers[r]->match(*matchers[i]);
+            if (!edge_map.empty()) {
+                representative_[i] = r;
+                rep_edge_[i] = std::move(edge_map);
+                break;
+            }
+        }
+        if (representative_[i] == i) {
+            reps.push_back(i);
+        }
+    }
+}
+
+BiMDFResult BiMDF_ConnectedComponents::map_solution(
+        size_t i,
+        const BiMDFResult &_rep_sol) const
+{
+    if (representative_[i] == i) {
+        throw std::logic_error("map_solution: sub-problem is its own representative");
+    }
+    const auto &sub = *views_[i];
+    auto sol = std::make_unique<BiMDF::Solution>(sub.g);
+    for (const auto e: sub.g.edges()) {
+        (*sol)[e] = (*_rep_sol.solution)[rep_edge_[i][sub.g.id(e)]];
+    }
+    return {.solution = std::move(sol),
+            .cost = _rep_sol.cost};
+}
+
 BiMDFResult BiMDF_ConnectedComponents::translate_solutions(
             std::vector<BiMDFResult> const&_sols) const
 {
@@ -184,6 +714,13 @@ BiMDFResult BiMDF_ConnectedComponents::translate_solutions(
         total_cost += res.cost;
     }
     auto orig_sol = std::make_unique<BiMDF::Solution>(orig_.g, 0);
+    if (!bimdfs_) {
+        if (n_cc_ == 1) {
+            lemon::mapCopy(orig_.g, *_sols[0].solution, *orig_sol);
+        }
+        return {.solution = std::move(orig_sol),
+                .cost = total_cost};
+    }
     for (const auto e: orig_.g.edges()) {
         auto u_cc = node_cc_[orig_.g.u(e)];
         assert(u_cc == node_cc_[orig_.g.v(e)]);
@@ -3,13 +3,15 @@
 #pragma once
 
 #include <libsatsuma/Problems/BiMDF.hh>
-#include <span>
+#include <vector>
 
 namespace Satsuma {
 
 /// Split BiMDF problem into connected components
 /// For an efficient implementation, we would use dynamic subgraph adapters,
 /// but some of the current code relies on accessing the complete graph.
+/// As a compromise, a problem that consists of a single sub-problem is not copied,
+/// bimdf(0) refers to the original problem then.
 /// TODO PERF: do use dynamic subgraph adapters
 class BiMDF_ConnectedComponents
 {
@@ -19,16 +21,48 @@ public:
     template<typename T> using NodeMap = BiMDF::NodeMap<T>;
     template<typename T> using EdgeMap = BiMDF::EdgeMap<T>;
 
+    struct Config {
+        /// Pack all components with fewer edges into a single sub-problem
+        /// (consisting of several components) to save per-problem overhead.
+        size_t pack_below_edges = 0;
+        /// Also pack trees and components with a single cycle.
+        bool pack_low_cyclomatic = true;
+        /// Detect components that are identical up to relabeling of nodes and edges
+        /// (demands, bounds, head flags and cost functions), see representative().
+        bool deduplicate = false;
+        /// Threads for component labelling (concurrent union-find), 0: all hardware threads.
+        /// With 1, lemon::connectedComponents is used.
+        unsigned threads = 1;
+        int verbosity = 2;
+    };
+
     BiMDF_ConnectedComponents(BiMDF const &_orig);
-    std::span<BiMDF> bimdfs() const {return {bimdfs_.get(), bimdfs_.get()+n_cc_};}
+    BiMDF_ConnectedComponents(BiMDF const &_orig, Config const &_config);
+    /// Number of sub-problems
+    size_t size() const {return n_cc_;}
+    BiMDF const& bimdf(size_t i) const {return *views_[i];}
+    /// Number of connected components in sub-problem `i` (1 unless packed)
+    size_t n_components(size_t i) const {return n_components_[i];}
+    /// Index of the sub-problem that sub-problem `i` is identical to, or `i` itself.
+    /// Always <= i, so duplicates can be mapped once their representative is solved.
+    size_t representative(size_t i) const {return representative_[i];}
+    /// Map a solution of the representative of sub-problem `i` to sub-problem `i`.
+    BiMDFResult map_solution(size_t i, BiMDFResult const &_rep_sol) const;
     BiMDFResult translate_solutions(std::vector<BiMDFResult> const&_sols) const;
 private:
+    void deduplicate();
+
     BiMDF const &orig_;
     NodeMap<size_t> node_cc_;
     NodeMap<Node> sub_node_; // node id in the corresponding cc subgraph
     EdgeMap<Edge> sub_edge_; // node id in the corresponding cc subgraph
     size_t n_cc_ = 0;
-    std::unique_ptr<BiMDF[]> bimdfs_;
+    std::unique_ptr<BiMDF[]> bimdfs_; // only allocated for more than one sub-problem
+    std::vector<BiMDF const*> views_;
+    std::vector<size_t> n_components_;
+    std::vector<size_t> representative_;
+    /// for duplicates: edge of the representative for each sub-problem edge id
+    std::vector<std::vector<Edge>> rep_edge_;
 };
 
 /// Create simplified BiMDF problem by collapsing demand-0 nodes
@@ -41,8 +75,12 @@ public:
     template<typename T> using NodeMap = BiMDF::NodeMap<T>;
     template<typename T> using EdgeMap = BiMDF::EdgeMap<T>;
 
-    BiMDF_Simplification(BiMDF const &_orig);
+    /// Chains are detected and their cost functions built using up to `_threads`
+    /// threads (0: all hardware threads).
+    BiMDF_Simplification(BiMDF const &_orig, int _verbosity = 2, unsigned _threads = 1);
     BiMDF const& bimdf() const {return simp_;}
+    /// Mutable access, e.g. to install a CostTable
+    BiMDF & bimdf() {return simp_;}
     BiMDFResult translate_solution(const BiMDFResult &_simp_result) const;
 private:
     BiMDF const &orig_;
@@ -1,13 +1,17 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Reductions/BiMDF_to_BiMCF.hh>
+#include <libsatsuma/Problems/CostBatch.hh>
+#include <libsatsuma/Problems/HomogeneousCosts.hh>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 
 namespace Satsuma {
 
-int add_capacities(int a, int b) {
+BiMCF::FlowScalar add_capacities(BiMCF::FlowScalar a, BiMCF::FlowScalar b) {
   if (a == BiMCF::inf() || b == BiMCF::inf()) {
     return BiMCF::inf();
   }
@@ -48,14 +52,14 @@ BiMDF_to_BiMCF::BiMDF_to_BiMCF(const BiMDF &_bimdf, Config const& _config)
         if (_config.out_orig_node) {
             (**_config.out_orig_node)[mcf_node] = mcf_node; // not a bug: nodes are identity-mapped, but added in reverse order with ListGraph
         }
-        bimcf_.demand[mcf_node] = 0;
+        bimcf_.demand[mcf_node] = bimdf_.demand[mcf_node];
     }
 
     double last_arc_cost = std::numeric_limits<double>::quiet_NaN();
     bool last_forward = false;
     BiMDF::Edge last_mdf_edge = lemon::INVALID;
     BiMDF::Edge last_edge = lemon::INVALID;
-    auto add_edge = [&](BiMDF::Edge mdf_edge, bool forward, double cost, int upper = BiMCF::inf())
+    auto add_edge = [&](BiMDF::Edge mdf_edge, bool forward, double cost, BiMCF::FlowScalar upper = BiMCF::inf())
       -> BiMCF::Edge
     {
         if (upper <= 0)
@@ -94,103 +98,180 @@ BiMDF_to_BiMCF::BiMDF_to_BiMCF(const BiMDF &_bimdf, Config const& _config)
         }
     };
 
-    for (const auto mdf_edge: bimdf_.g.edges())
-    {
-        const auto guess = _config.guess[mdf_edge];
-        guess_[mdf_edge] = guess;
-        auto u = bimdf_.g.u(mdf_edge);
-        auto v = bimdf_.g.v(mdf_edge);
-        // TODO: applying flow should be a BiFlowGraph member function:
-        bimcf_.demand[u] += bimdf_.u_head[mdf_edge] ? -guess : guess;
-        bimcf_.demand[v] += bimdf_.v_head[mdf_edge] ? -guess : guess;
-
-        //const double weight = bimdf_.weight[mdf_edge];
-        //const double target = bimdf_.target[mdf_edge];
-
-        auto energy = [&](int val) {
-            return bimdf_.cost(mdf_edge, val);
-        };
-        const auto lower = bimdf_.lower[mdf_edge];
-        const auto upper = bimdf_.upper[mdf_edge];
-        const int cap = _config.even ? 2 : 1;
-        const double guess_cost = energy(guess);
-        double ecost = guess_cost;
-
-        int dev = 0;
-
-
-        // forward arcs:
-        for (int i = cap; i <= _config.max_deviation; i += cap) {
-            int remain = upper - guess - (i - cap); // remaining capacity capacity after applying all *previous* arcs
-            int remcap = std::min(cap, remain);
-            if (remcap <= 0)
-                break;
-            auto last_cost = ecost;
-            dev = i - cap + remcap;
-            ecost = energy(guess+dev);
-            double arc_cost = (ecost - last_cost)/remcap;
-#if 0
-            std::cout << "CCCC cost for forward edge "
-                      << bimdf_.g.id(u) << " - " << bimdf_.g.id(v)
-                      << ", i = " << i
-                      << ", upper = " << upper
-                      << ", remcap = " << remcap
-                      << ", last_cost = " << last_cost
-                      << ", arc_cost = " << arc_cost
-                      //<< ", last_arc_cost = " << last_arc_cost
-                      << ", ecost =     " << ecost
-                      << ", result:" << arc_cost
-                      << std::endl;
-#endif
-            add_edge(mdf_edge, true, arc_cost, remcap);
-        }
+    // Instantiated per cost type for homogeneous problems, see with_homogeneous_cost_type.
+    with_homogeneous_cost_type(bimdf_, [&](auto cost_type) {
+        using CostT = typename decltype(cost_type)::type;
+        constexpr bool generic = std::is_same_v<CostT, CostFunction::Function>;
 
-        const int last_arc_dx = 10;
-        if (_config.last_arc_uncapacitated) {
-            auto cost = (energy(guess + dev + last_arc_dx)
-                       - energy(guess + dev)) / last_arc_dx;
-            assert(cost >= 0);
-            if (cost < 0 ) { cost = 0;}  // we never want an unbounded arc with negative costs!
-            int remain = upper;
-            if (upper < BiMCF::inf()) {
-                remain -= dev;
+        // Generic costs around the guess are evaluated in batch, unless the window gets too large
+        // (e.g. for an unlimited deviation). Others are evaluated one by one.
+        const int max_window_radius = 4;
+        int window_radius = _config.max_deviation;
+        if (_config.max_edge_deviation) {
+            window_radius = 0;
+            for (const auto mdf_edge: bimdf_.g.edges()) {
+                window_radius = std::max(window_radius, (*_config.max_edge_deviation)[mdf_edge]);
             }
-            add_edge(mdf_edge, true, cost, remain);
         }
-
-        // backwards arcs:
-        ecost = guess_cost;
-        for (int i = cap; i <= _config.max_deviation; i += cap) {
-            int remain = guess - lower - (i-cap); // remaining capacity capacity after applying all *previous* arcs
-            int remcap = std::min(cap, remain);
-            if (remcap <= 0)
-                break;
-            auto last_cost = ecost;
-            dev = i - cap + remcap;
-            ecost = energy(guess - dev);
-            double arc_cost = (ecost - last_cost)/remcap;
-#if 0
-            std::cout << "DDDD cost for backward edge "
-                      << bimdf_.g.id(u) << " - " << bimdf_.g.id(v)
-                      << ", i = " << i
-                      << ", upper = " << upper
-                      << ", remcap = " << remcap
-                      << ", last_cost = " << last_cost
-                      << ", arc_cost = " << arc_cost
-                      //<< ", last_arc_cost = " << last_arc_cost
-                      << ", ecost =     " << ecost
-                      << ", result:" << arc_cost
-                      << std::endl;
-#endif
-            add_edge(mdf_edge, false, arc_cost, remcap);
+        std::vector<double> window_cost;
+        if (generic && window_radius <= max_window_radius) {
+            CostBatch(bimdf_).evaluate_window(_config.guess, window_radius, window_cost);
         }
-        auto remain = guess - lower - dev;
-        if (_config.last_arc_uncapacitated && remain > 0) {
-            auto cost = (energy(guess - dev - remain)
-                       - energy(guess - dev)) / remain;
-            add_edge(mdf_edge, false, cost, remain);
+        const size_t window_width = 2 * window_radius + 1;
+
+        for (const auto mdf_edge: bimdf_.g.edges())
+        {
+            const auto guess = _config.guess[mdf_edge];
+            guess_[mdf_edge] = guess;
+            auto u = bimdf_.g.u(mdf_edge);
+            auto v = bimdf_.g.v(mdf_edge);
+            // TODO: applying flow should be a BiFlowGraph member function:
+            bimcf_.demand[u] += bimdf_.u_head[mdf_edge] ? -guess : guess;
+            bimcf_.demand[v] += bimdf_.v_head[mdf_edge] ? -guess : guess;
+
+            //const double weight = bimdf_.weight[mdf_edge];
+            //const double target = bimdf_.target[mdf_edge];
+
+            const double *edge_window = window_cost.empty()
+                                      ? nullptr
+                                      : &window_cost[bimdf_.g.id(mdf_edge) * window_width + window_radius];
+            auto energy = [&](BiMCF::FlowScalar val) {
+                const auto d = val - guess;
+                if (edge_window && std::abs(d) <= window_radius) {
+                    return edge_window[d];
+                }
+                return edge_cost<CostT>(bimdf_, mdf_edge, val);
+            };
+            const auto lower = bimdf_.lower[mdf_edge];
+            const auto upper = bimdf_.upper[mdf_edge];
+            const int cap = _config.even ? 2 : 1;
+            const int max_deviation = _config.max_edge_deviation
+                                    ? (*_config.max_edge_deviation)[mdf_edge]
+                                    : _config.max_deviation;
+
+            auto pl = std::get_if<CostFunction::PiecewiseLinear>(&bimdf_.cost_function[mdf_edge]);
+            if (pl && _config.last_arc_uncapacitated) {
+                // Exact representation without deviation limit: one arc per linear segment
+                // (of the function restricted to multiples of `cap` around the guess),
+                // the outermost one with the remaining capacity.
+                auto add_segment_arcs = [&](bool forward) {
+                    const int sign = forward ? 1 : -1;
+                    const long long room = forward
+                        ? (upper == BiMCF::inf() ? BiMCF::inf() : static_cast<long long>(upper) - guess)
+                        : static_cast<long long>(guess) - lower;
+                    std::vector<long long> knots;
+                    for (const auto b: pl->breakpoints()) {
+                        const double rel = sign * (b - guess) / cap;
+                        for (const auto r: {std::floor(rel), std::ceil(rel)}) {
+                            const auto k = cap * static_cast<long long>(r);
+                            if (k > 0 && k < room) {
+                                knots.push_back(k);
+                            }
+                        }
+                    }
+                    std::sort(knots.begin(), knots.end());
+                    knots.erase(std::unique(knots.begin(), knots.end()), knots.end());
+                    long long prev = 0;
+                    for (const auto k: knots) {
+                        const double arc_cost = (energy(guess + sign * k) - energy(guess + sign * prev)) / (k - prev);
+                        add_edge(mdf_edge, forward, arc_cost, k - prev);
+                        prev = k;
+                    }
+                    if (room > prev) {
+                        double arc_cost = (energy(guess + sign * (prev + cap)) - energy(guess + sign * prev)) / cap;
+                        if (room >= BiMCF::inf()) {
+                            arc_cost = std::max(arc_cost, 0.); // never an unbounded arc with negative costs
+                            add_edge(mdf_edge, forward, arc_cost, BiMCF::inf());
+                        } else {
+                            add_edge(mdf_edge, forward, arc_cost, room - prev);
+                        }
+                    }
+                };
+                add_segment_arcs(true);
+                add_segment_arcs(false);
+                continue;
+            }
+
+            const double guess_cost = energy(guess);
+            double ecost = guess_cost;
+
+            int dev = 0;
+
+
+            // forward arcs:
+            for (int i = cap; i <= max_deviation; i += cap) {
+                BiMCF::FlowScalar remain = upper - guess - (i - cap); // remaining capacity capacity after applying all *previous* arcs
+                int remcap = static_cast<int>(std::min<BiMCF::FlowScalar>(cap, remain));
+                if (remcap <= 0)
+                    break;
+                auto last_cost = ecost;
+                dev = i - cap + remcap;
+                ecost = energy(guess+dev);
+                double arc_cost = (ecost - last_cost)/remcap;
+    #if 0
+                std::cout << "CCCC cost for forward edge "
+                          << bimdf_.g.id(u) << " - " << bimdf_.g.id(v)
+                          << ", i = " << i
+                          << ", upper = " << upper
+                          << ", remcap = " << remcap
+                          << ", last_cost = " << last_cost
+                          << ", arc_cost = " << arc_cost
+                          //<< ", last_arc_cost = " << last_arc_cost
+                          << ", ecost =     " << ecost
+                          << ", result:" << arc_cost
+                          << std::endl;
+    #endif
+                add_edge(mdf_edge, true, arc_cost, remcap);
+            }
+
+            const int last_arc_dx = 10;
+            if (_config.last_arc_uncapacitated) {
+                auto cost = (energy(guess + dev + last_arc_dx)
+                           - energy(guess + dev)) / last_arc_dx;
+                assert(cost >= 0);
+                if (cost < 0 ) { cost = 0;}  // we never want an unbounded arc with negative costs!
+                BiMCF::FlowScalar remain = upper;
+                if (upper < BiMCF::inf()) {
+                    remain -= guess + dev;
+                }
+                add_edge(mdf_edge, true, cost, remain);
+            }
+
+            // backwards arcs:
+            ecost = guess_cost;
+            dev = 0;
+            for (int i = cap; i <= max_deviation; i += cap) {
+                BiMCF::FlowScalar remain = guess - lower - (i-cap); // remaining capacity capacity after applying all *previous* arcs
+                int remcap = static_cast<int>(std::min<BiMCF::FlowScalar>(cap, remain));
+                if (remcap <= 0)
+                    break;
+                auto last_cost = ecost;
+                dev = i - cap + remcap;
+                ecost = energy(guess - dev);
+                double arc_cost = (ecost - last_cost)/remcap;
+    #if 0
+                std::cout << "DDDD cost for backward edge "
+                          << bimdf_.g.id(u) << " - " << bimdf_.g.id(v)
+                          << ", i = " << i
+                          << ", upper = " << upper
+                          << ", remcap = " << remcap
+                          << ", last_cost = " << last_cost
+                          << ", arc_cost = " << arc_cost
+                          //<< ", last_arc_cost = " << last_arc_cost
+                          << ", ecost =     " << ecost
+                          << ", result:" << arc_cost
+                          << std::endl;
+    #endif
+                add_edge(mdf_edge, false, arc_cost, remcap);
+            }
+            auto remain = guess - lower - dev;
+            if (_config.last_arc_uncapacitated && remain > 0) {
+                auto cost = (energy(guess - dev - remain)
+                           - energy(guess - dev)) / remain;
+                add_edge(mdf_edge, false, cost, remain);
+            }
         }
-    }
+    });
 
 #if 0
     std::cerr << "Bi-MDF |V| = " << bimdf_.g.maxNodeId()+1
@@ -12,6 +12,8 @@ public:
     struct Config {
         const BiMDF::Guess &guess;// result = guess + mcf flow
         BiFlowGraph::FlowScalar max_deviation = 2;// currently only honored for refinement mode
+        /// if set, overrides max_deviation per edge (0: keep the edge fixed at its guess)
+        const BiMDF::EdgeMap<int> *max_edge_deviation = nullptr;
         bool last_arc_uncapacitated = true;
         bool even = false;
         bool consolidate = true;
@@ -24,6 +26,11 @@ public:
     /// XXX double_guess for half-integral optimum
     BiMDFResult translate_solution(const BiMCFResult &bimcf_res, bool double_guess=false) const;
 
+    /// BiMDF edge whose flow is changed by BiMCF edge `e`
+    BiMDF::Edge orig_bimdf_edge(BiMCF::Edge e) const {return bimdf_.g.edgeFromId(mdf_edge_id_[e]);}
+    /// true if flow on `e` increases the flow of orig_bimdf_edge(e), false if it decreases it
+    bool is_forward(BiMCF::Edge e) const {return is_forward_[e];}
+
 private:
 
     BiMDF const& bimdf_;
@@ -8,6 +8,7 @@ namespace Satsuma {
 
 OrientedBiMCF::OrientedBiMCF(BiMCF const &_bimcf, Orientation const &ori)
     : bimcf_(_bimcf)
+    , cost_scaling_(abs_cost_sum(_bimcf))
 {
     size_t n_nodes = bimcf_.g.maxNodeId() + 1;
     size_t n_arcs = bimcf_.g.maxEdgeId() + 1;
@@ -43,7 +44,7 @@ OrientedBiMCF::OrientedBiMCF(BiMCF const &_bimcf, Orientation const &ori)
         assert(mcf_.g.id(new_e) == i);
         mcf_.upper[new_e] = bimcf_.upper[e];
         mcf_.lower[new_e] = bimcf_.lower[e];
-        mcf_.cost[new_e] = std::llround(bimcf_.cost[e]*costmul_);
+        mcf_.cost[new_e] = cost_scaling_.scale(bimcf_.cost[e]);
     }
 }
 BiMCFResult OrientedBiMCF::translate_solution(const MCFResult &mcf_result) const
@@ -59,7 +60,7 @@ BiMCFResult OrientedBiMCF::translate_solution(const MCFResult &mcf_result) const
         max_flow = std::max(max_flow, val);
     }
     return {.solution = std::move(bimcf_solp),
-            .cost = mcf_result.cost / costmul_,
+            .cost = cost_scaling_.unscale(mcf_.compute_cost(mcf_sol)),
             .max_flow = max_flow};
 
 }
@@ -2,6 +2,7 @@
 
 #include <libsatsuma/Problems/BiMCF.hh>
 #include <libsatsuma/Problems/MCF.hh>
+#include <libsatsuma/Problems/CostScaling.hh>
 #include <libsatsuma/Solvers/OrientBinet.hh>
 
 namespace Satsuma {
@@ -15,7 +16,7 @@ private:
     BiMCF const& bimcf_;
     MCF mcf_;
     MCF::ArcMap<BiMCF::Edge> orig_bimcf_edge_{mcf_.g};
-    const double costmul_ = 1000;
+    CostScaling cost_scaling_;
 };
 
 } // namespace Satsuma
@@ -0,0 +1,231 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Solvers/BiMDFCycleCanceling.hh>
+#include <libsatsuma/Reductions/BiMDF_to_BiMCF.hh>
+#include <libsatsuma/Reductions/BiMCF_to_MCF.hh>
+#include <libsatsuma/Problems/MCF.hh>
+
+#include <lemon/maps.h>
+#include <deque>
+#include <vector>
+#include <iostream>
+
+namespace Satsuma {
+
+using Cycle = std::vector<MCF::Arc>;
+
+/// Return all cycles of the predecessor graph. Every such cycle has negative cost.
+static std::vector<Cycle>
+predecessor_cycles(MCF const &mcf, MCF::NodeMap<MCF::Arc> const &pred)
+{
+    const auto &g = mcf.g;
+    std::vector<Cycle> cycles;
+    MCF::NodeMap<int> walk_id{g, -1};
+    int walk = 0;
+    for (const auto start: g.nodes()) {
+        if (walk_id[start] != -1) {
+            continue;
+        }
+        auto n = start;
+        while (walk_id[n] == -1) {
+            walk_id[n] = walk;
+            if (pred[n] == lemon::INVALID) {
+                break;
+            }
+            n = g.source(pred[n]);
+        }
+        if (walk_id[n] == walk && pred[n] != lemon::INVALID) {
+            // n lies on a cycle that we have not seen before.
+            Cycle cycle;
+            auto cur = n;
+            do {
+                cycle.push_back(pred[cur]);
+                cur = g.source(pred[cur]);
+            } while (cur != n);
+            cycles.push_back(std::move(cycle));
+        }
+        ++walk;
+    }
+    return cycles;
+}
+
+/// Queue-based Bellman-Ford starting from the distances in `dist`
+/// (all zero: from a virtual source connected to all nodes).
+/// Returns a set of node-disjoint negative cycles, or nothing if none exist;
+/// in the latter case, `dist` are potentials with non-negative reduced costs.
+static std::vector<Cycle>
+find_negative_cycles(MCF const &mcf, MCF::NodeMap<MCF::CostScalar> &dist)
+{
+    const auto &g = mcf.g;
+    const size_t n_nodes = g.maxNodeId() + 1;
+    MCF::NodeMap<MCF::Arc> pred{g, lemon::INVALID};
+    MCF::NodeMap<bool> in_queue{g, true};
+    std::deque<MCF::Node> queue;
+    for (const auto n: g.nodes()) {
+        queue.push_back(n);
+    }
+    size_t n_relaxations = 0;
+    while (!queue.empty()) {
+        auto u = queue.front();
+        queue.pop_front();
+        in_queue[u] = false;
+        for (const auto a: g.outArcs(u)) {
+            auto v = g.target(a);
+            auto d = dist[u] + mcf.cost[a];
+            if (d >= dist[v]) {
+                continue;
+            }
+            dist[v] = d;
+            pred[v] = a;
+            if (!in_queue[v]) {
+                in_queue[v] = true;
+                queue.push_back(v);
+            }
+            if (++n_relaxations % n_nodes == 0) {
+                auto cycles = predecessor_cycles(mcf, pred);
+                if (!cycles.empty()) {
+                    return cycles;
+                }
+            }
+        }
+    }
+    return {};
+}
+
+BiMDFRefinementResult refine_with_cycle_canceling(const BiMDF &_bimdf,
+                                                  BiMDF::Solution const& f0,
+                                                  int max_deviation,
+                                                  int verbosity)
+{
+    const auto &g = _bimdf.g;
+    auto sol = std::make_unique<BiMDF::Solution>(g);
+    lemon::mapCopy(g, f0, *sol);
+
+    BiMDF::CostScalar total_change = 0;
+    BiMDF::EdgeMap<BiMDF::FlowScalar> change{g, 0};
+    BiMDF::EdgeMap<bool> touched{g, false};
+    BiMDF::EdgeMap<size_t> seen_in_cycle{g, 0};
+    size_t cycle_id = 0;
+
+    for (int round = 0; ; ++round) {
+        auto red_bimcf = BiMDF_to_BiMCF(_bimdf, {
+            .guess = *sol,
+            .max_deviation = static_cast<BiMDF::FlowScalar>(max_deviation),
+            .last_arc_uncapacitated = false,
+            .even = false,
+            .consolidate = true});
+        auto red_mcf = BiMCF_to_MCF(red_bimcf.bimcf(), {
+            .method = BiMCF_to_MCF::Method::NotEven});
+        const auto &bimcf = red_bimcf.bimcf();
+
+        MCF::NodeMap<MCF::CostScalar> dist{red_mcf.mcf().g, 0};
+        auto cycles = find_negative_cycles(red_mcf.mcf(), dist);
+        if (cycles.empty()) {
+            break;
+        }
+
+        // Each double cover cycle maps to a circulation in the residual BiMCF.
+        // Cycles found in the same round may share BiMDF edges, in which case
+        // their cost changes are not additive; we only cancel edge-disjoint ones.
+        BiMCF::EdgeMap<BiMCF::FlowScalar> usage{bimcf.g, 0};
+        std::vector<BiMDF::Edge> touched_now;
+        size_t n_cancelled = 0;
+        BiMDF::CostScalar round_change = 0;
+        for (const auto &cycle: cycles) {
+            ++cycle_id;
+            std::vector<BiMCF::Edge> bimcf_edges;
+            std::vector<BiMDF::Edge> mdf_edges;
+            bool feasible = true;
+            for (const auto a: cycle) {
+                auto e = red_mcf.orig_bimcf_edge(a);
+                if (usage[e]++ == 0) {
+                    bimcf_edges.push_back(e);
+                }
+                if (usage[e] > bimcf.upper[e]) {
+                    feasible = false;
+                }
+                auto mdf_edge = red_bimcf.orig_bimdf_edge(e);
+                if (touched[mdf_edge]) {
+                    feasible = false;
+                }
+                if (seen_in_cycle[mdf_edge] != cycle_id) {
+                    seen_in_cycle[mdf_edge] = cycle_id;
+                    mdf_edges.push_back(mdf_edge);
+                }
+                change[mdf_edge] += red_bimcf.is_forward(e) ? 1 : -1;
+            }
+            BiMDF::CostScalar cost_change = 0;
+            if (feasible) {
+                for (const auto e: mdf_edges) {
+                    cost_change += _bimdf.cost(e, (*sol)[e] + change[e])
+                                 - _bimdf.cost(e, (*sol)[e]);
+                }
+            }
+            // cost change is computed on the actual cost functions to be robust
+            // against rounding of the scaled integer double cover costs.
+            if (feasible && cost_change < 0) {
+                for (const auto e: mdf_edges) {
+                    (*sol)[e] += change[e];
+                    touched[e] = true;
+                    touched_now.push_back(e);
+                }
+                round_change += cost_change;
+                ++n_cancelled;
+            }
+            for (const auto e: mdf_edges) {
+                change[e] = 0;
+            }
+            for (const auto e: bimcf_edges) {
+                usage[e] = 0;
+            }
+        }
+        for (const auto e: touched_now) {
+            touched[e] = false;
+        }
+        if (verbosity >= 3) {
+            std::cout << "cycle canceling round " << round
+                      << ": cancelled " << n_cancelled << " / " << cycles.size()
+                      << " cycles, cost ch. " << round_change
+                      << std::endl;
+        }
+        if (n_cancelled == 0) {
+            break;
+        }
+        total_change += round_change;
+    }
+    return {.sol = std::move(sol),
+            .cost_change = total_change};
+}
+
+bool refinement_certificate(const BiMDF &_bimdf,
+                            BiMDF::Solution const& sol,
+                            int max_deviation,
+                            std::vector<MCF::CostScalar> &potential)
+{
+    auto red_bimcf = BiMDF_to_BiMCF(_bimdf, {
+        .guess = sol,
+        .max_deviation = static_cast<BiMDF::FlowScalar>(max_deviation),
+        .last_arc_uncapacitated = false,
+        .even = false,
+        .consolidate = true});
+    auto red_mcf = BiMCF_to_MCF(red_bimcf.bimcf(), {
+        .method = BiMCF_to_MCF::Method::NotEven});
+    const auto &mcf = red_mcf.mcf();
+    const auto &g = mcf.g;
+
+    potential.resize(g.maxNodeId() + 1, 0);
+    MCF::NodeMap<MCF::CostScalar> dist{g};
+    for (const auto n: g.nodes()) {
+        dist[n] = potential[g.id(n)];
+    }
+    // all arcs have residual capacity at zero flow, so this is the full residual graph.
+    if (!find_negative_cycles(mcf, dist).empty()) {
+        return false;
+    }
+    for (const auto n: g.nodes()) {
+        potential[g.id(n)] = dist[n];
+    }
+    return true;
+}
+
+} // namespace Satsuma
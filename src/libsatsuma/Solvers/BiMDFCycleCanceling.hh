@@ -0,0 +1,43 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Solvers/BiMDFRefinement.hh>
+#include <libsatsuma/Problems/MCF.hh>
+#include <vector>
+
+namespace Satsuma {
+
+/// Improve `f0` by repeatedly cancelling negative-cost closed walks (cycles and bicycles)
+/// in the bidirected residual graph of `f0`.
+///
+/// The residual graph is the BiMCF of BiMDF_to_BiMCF with guess `f0`; its closed walks
+/// are found as directed cycles in the (NotEven) double cover using a queue-based
+/// Bellman-Ford search. Each round cancels a set of edge-disjoint negative cycles,
+/// rounds are repeated until no improving cycle remains.
+///
+/// Unlike refine_with_matching, the result is not guaranteed to be optimal:
+/// some improving closed walks use both copies of a residual edge and
+/// can not be represented by a single cycle in the double cover.
+/// Use a final matching refinement to confirm optimality.
+BiMDFRefinementResult refine_with_cycle_canceling(const BiMDF &_bimdf,
+                                                  BiMDF::Solution const& f0,
+                                                  int max_deviation = 2,
+                                                  int verbosity = 0);
+
+/// Sufficient optimality check for refinement of `sol` with `max_deviation`:
+/// returns true if the (NotEven) double cover of the refinement problem
+/// has no negative cycle, certified by node potentials with non-negative
+/// reduced costs on all arcs. In that case, neither refine_with_matching
+/// nor refine_with_cycle_canceling can improve `sol`.
+///
+/// `potential` is indexed by double cover node id (2*id and 2*id+1 for BiMDF node `id`)
+/// and used as warm start, e.g. from a previous check or a double cover solve.
+/// On success, it is replaced by the certificate.
+bool refinement_certificate(const BiMDF &_bimdf,
+                            BiMDF::Solution const& sol,
+                            int max_deviation,
+                            std::vector<MCF::CostScalar> &potential);
+
+} // namespace Satsuma
@@ -35,7 +35,7 @@ approximate_bimdf_doublecover(
     sw_reductions.resume();
     auto red_bimcf = BiMDF_to_BiMCF(_bimdf, {
             .guess = *evening.guess,
-            .max_deviation = _config.max_deviation,
+            .max_deviation = static_cast<BiMDF::FlowScalar>(_config.max_deviation),
             .last_arc_uncapacitated = true,
             .even = true,
             .consolidate = true});
@@ -64,9 +64,17 @@ approximate_bimdf_doublecover(
         throw InternalError("approximation result infeasible.");
     }
 
+    const auto &mcf_g = red_mcf.mcf().g;
+    std::vector<MCF::CostScalar> potential(mcf_g.maxNodeId() + 1, 0);
+    for (const auto n: mcf_g.nodes()) {
+        potential[mcf_g.id(n)] = (*sol_mcf.potential)[n];
+    }
+
     auto cost = _bimdf.cost(*sol_bimdf.solution);
     sw_root.stop();
     return {.solution = std::move(sol_bimdf.solution),
+            .potential = std::move(potential),
+            .potential_multiplier = red_mcf.cost_multiplier(),
             .info = {
                 .evening_cost = evening.cost,
                 .evening_n_adjustments = evening.n_adjustments,
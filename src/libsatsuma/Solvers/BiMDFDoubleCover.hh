@@ -26,6 +26,11 @@ struct BiMDFDoubleCoverInfo {
 
 struct BiMDFDoubleCoverResult {
     std::unique_ptr<BiMDF::Solution> solution;
+    /// Node potentials of the double cover solve, indexed by double cover node id
+    /// (2*id and 2*id+1 for BiMDF node `id`).
+    std::vector<MCF::CostScalar> potential;
+    /// Cost multiplier the potentials refer to, see CostScaling
+    double potential_multiplier = CostScaling::default_max_multiplier;
     BiMDFDoubleCoverInfo info;
     Timekeeper::HierarchicalStopWatchResult stopwatch;
 };
@@ -1,42 +1,35 @@
 //  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Solvers/BiMDFGuess.hh>
+#include <libsatsuma/Problems/HomogeneousCosts.hh>
 
 namespace Satsuma {
 
-std::unique_ptr<BiMDF::Guess> make_guess(const BiMDF &bimdf)
+template<typename CostT>
+static std::unique_ptr<BiMDF::Guess> make_guess_impl(const BiMDF &bimdf)
 {
     auto guessp = std::make_unique<BiMDF::Guess>(bimdf.g);
     auto &guess = *guessp;
 
     for (const auto e: bimdf.g.edges())
     {
-        auto target = bimdf.guess(e);
-
-        auto floor = static_cast<BiMDF::FlowScalar>(std::llround(std::floor(target)));
-        auto ceil = static_cast<BiMDF::FlowScalar>(std::llround(std::ceil(target)));
-        floor = std::max(floor, bimdf.lower[e]);
-        ceil = std::min(floor, bimdf.upper[e]);
-        if(floor > ceil) {
-            guess[e] = floor;
+        const auto lower = bimdf.lower[e];
+        const auto upper = bimdf.upper[e];
+        if (lower >= upper) {
+            guess[e] = lower;
         } else {
-            auto min_cost = std::numeric_limits<BiMDF::CostScalar>::infinity();
-            auto last_cost = std::numeric_limits<BiMDF::CostScalar>::infinity();
-            for (auto x = floor; x <= ceil; ++x) {
-                auto cost = bimdf.cost(e, x);
-                if (cost > last_cost) {
-                    // increasing cost -> we are past the minimum of the convex cost function
-                    break;
-                }
-                last_cost = cost;
-                if (cost < min_cost) {
-                    min_cost = cost;
-                    guess[e] = x;
-                }
-            }
+            guess[e] = static_cast<BiMDF::FlowScalar>(
+                    edge_argmin<CostT>(bimdf, e, lower, upper));
         }
     }
     return guessp;
 }
 
+std::unique_ptr<BiMDF::Guess> make_guess(const BiMDF &bimdf)
+{
+    return with_homogeneous_cost_type(bimdf, [&](auto cost_type) {
+        return make_guess_impl<typename decltype(cost_type)::type>(bimdf);
+    });
+}
+
 } // namespace Satsuma
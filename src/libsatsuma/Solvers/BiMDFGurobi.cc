@@ -75,6 +75,19 @@ BiMDFResult solve_bimdf_gurobi(BiMDF const &bimdf, bool int_targets, BiMDF::Gues
 
                 GRBLinExpr dev = ev - f->target;
                 obj += f->weight * dev * dev;
+            } else if (auto f = std::get_if<CostFunction::PiecewiseLinear>(&cost_func)) {
+                // Gurobi extrapolates the first and last segments
+                std::vector<double> xs = f->breakpoints();
+                if (xs.empty()) {
+                    xs.push_back(0.);
+                }
+                xs.insert(xs.begin(), xs.front() - 1.);
+                xs.push_back(xs.back() + 1.);
+                std::vector<double> ys;
+                for (const auto x: xs) {
+                    ys.push_back((*f)(x));
+                }
+                model.setPWLObj(ev, static_cast<int>(xs.size()), xs.data(), ys.data());
             }
             else {
               assert(false);
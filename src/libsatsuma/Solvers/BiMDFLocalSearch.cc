@@ -0,0 +1,153 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Solvers/BiMDFLocalSearch.hh>
+
+#include <lemon/maps.h>
+#include <limits>
+#include <vector>
+
+namespace Satsuma {
+
+namespace {
+
+class LocalSearch
+{
+public:
+    LocalSearch(const BiMDF &_bimdf,
+                BiMDF::Solution &_sol,
+                BiMDFLocalSearchConfig const &_config)
+        : bimdf_(_bimdf)
+        , g_(_bimdf.g)
+        , sol_(_sol)
+        , config_(_config)
+    {}
+
+    /// Try to find and apply an improving cycle that starts at `start`
+    /// with edge `e` changing by `sign * step`. Returns the (negative) cost change or 0.
+    BiMDF::CostScalar improve(BiMDF::Arc first, int step, int sign)
+    {
+        step_ = step;
+        start_ = g_.source(first);
+        path_.clear();
+        ++stamp_;
+        // contribution of `first` to the balance of the start node:
+        const BiMDF::Edge e = first;
+        const bool start_head = g_.direction(first) ? bimdf_.u_head[e] : bimdf_.v_head[e];
+        start_contribution_ = start_head ? sign : -sign;
+        node_stamp_[start_] = stamp_;
+        return extend(first, sign, 0.);
+    }
+
+private:
+    /// Flow change of edge `e` by `sign*step_` would cost this much (inf if infeasible).
+    BiMDF::CostScalar move_cost(BiMDF::Edge e, int sign) const
+    {
+        const auto x = sol_[e];
+        const auto y = x + sign * step_;
+        if (y < bimdf_.lower[e] || y > bimdf_.upper[e]) {
+            return std::numeric_limits<BiMDF::CostScalar>::infinity();
+        }
+        return bimdf_.cost(e, y) - bimdf_.cost(e, x);
+    }
+
+    BiMDF::CostScalar extend(BiMDF::Arc a, int sign, BiMDF::CostScalar partial)
+    {
+        const BiMDF::Edge e = a;
+        if (edge_stamp_[e] == stamp_) {
+            return 0;
+        }
+        partial += move_cost(e, sign);
+        if (!(partial < 0)) {
+            // positive gain criterion
+            return 0;
+        }
+        const auto n = g_.target(a);
+        const bool head = g_.direction(a) ? bimdf_.v_head[e] : bimdf_.u_head[e];
+        const int contribution = head ? sign : -sign;
+        if (n == start_) {
+            if (contribution != -start_contribution_ || partial > -1e-9) {
+                return 0;
+            }
+            path_.push_back({e, sign});
+            for (const auto &[pe, ps]: path_) {
+                sol_[pe] += ps * step_;
+            }
+            return partial;
+        }
+        if (node_stamp_[n] == stamp_
+                || static_cast<int>(path_.size()) + 1 >= config_.max_cycle_length) {
+            return 0;
+        }
+        edge_stamp_[e] = stamp_;
+        node_stamp_[n] = stamp_;
+        path_.push_back({e, sign});
+        for (const auto next: g_.outArcs(n)) {
+            const BiMDF::Edge next_e = next;
+            if (g_.u(next_e) == g_.v(next_e)) {
+                continue;
+            }
+            // the next edge must cancel our contribution at n:
+            const bool next_head = g_.direction(next) ? bimdf_.u_head[next_e] : bimdf_.v_head[next_e];
+            const int next_sign = next_head ? -contribution : contribution;
+            auto change = extend(next, next_sign, partial);
+            if (change < 0) {
+                return change;
+            }
+        }
+        path_.pop_back();
+        node_stamp_[n] = 0;
+        edge_stamp_[e] = 0;
+        return 0;
+    }
+
+    const BiMDF &bimdf_;
+    const BiMDF::GraphT &g_;
+    BiMDF::Solution &sol_;
+    BiMDFLocalSearchConfig const &config_;
+
+    BiMDF::EdgeMap<size_t> edge_stamp_{g_, 0};
+    BiMDF::NodeMap<size_t> node_stamp_{g_, 0};
+    size_t stamp_ = 0;
+
+    int step_ = 1;
+    BiMDF::Node start_;
+    int start_contribution_ = 0;
+    std::vector<std::pair<BiMDF::Edge, int>> path_;
+};
+
+} // namespace
+
+BiMDFRefinementResult refine_with_local_search(const BiMDF &_bimdf,
+                                               BiMDF::Solution const& f0,
+                                               BiMDFLocalSearchConfig const& _config)
+{
+    const auto &g = _bimdf.g;
+    auto sol = std::make_unique<BiMDF::Solution>(g);
+    lemon::mapCopy(g, f0, *sol);
+
+    LocalSearch search(_bimdf, *sol, _config);
+    BiMDF::CostScalar total_change = 0;
+    for (int sweep = 0; sweep < _config.max_sweeps; ++sweep) {
+        BiMDF::CostScalar sweep_change = 0;
+        for (const auto e: g.edges()) {
+            if (g.u(e) == g.v(e)) {
+                continue;
+            }
+            for (const auto a: {g.direct(e, true), g.direct(e, false)}) {
+                for (int step = 1; step <= _config.max_step; ++step) {
+                    for (const int sign: {1, -1}) {
+                        sweep_change += search.improve(a, step, sign);
+                    }
+                }
+            }
+        }
+        total_change += sweep_change;
+        if (sweep_change == 0) {
+            break;
+        }
+    }
+    return {.sol = std::move(sol),
+            .cost_change = total_change};
+}
+
+} // namespace Satsuma
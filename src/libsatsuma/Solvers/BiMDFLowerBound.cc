@@ -15,6 +15,7 @@ BiMDFLowerBoundResult bimdf_lower_bound(const BiMDF &bimdf,
     BiMDF::FlowScalar max_dev = initial_maxdev;
 
     auto best_cost = std::numeric_limits<MCF::CostScalar>::max();
+    double best_cost_multiplier = 0.;
     while (true) {
         auto red_bimcf = BiMDF_to_BiMCF(bimdf, {
                 .guess = *guessp,
@@ -31,7 +32,8 @@ BiMDFLowerBoundResult bimdf_lower_bound(const BiMDF &bimdf,
         auto sol_bimcf = red_mcf.translate_solution(sol_mcf);
         auto sol_bimdf = red_bimcf.translate_solution(sol_bimcf, true);
         // due to integer rounding, the bi-mcf cost may oscillate, so compare integer mcf cost.
-        auto cost = sol_mcf.cost;
+        // These are only comparable if the cost scaling did not change.
+        auto cost = red_mcf.mcf().compute_cost(*sol_mcf.solution);
 #if 0
         std::cout << "LB " << sol_bimcf.max_flow
                   << " / " << max_dev
@@ -43,8 +45,9 @@ BiMDFLowerBoundResult bimdf_lower_bound(const BiMDF &bimdf,
                   //<< ", full " << bimdf.cost(*sol_bimdf.solution)
                   << std::endl;
 #endif
-        if (cost != best_cost) {
+        if (cost != best_cost || red_mcf.cost_multiplier() != best_cost_multiplier) {
             best_cost = cost;
+            best_cost_multiplier = red_mcf.cost_multiplier();
             max_dev *= 2;
         } else {
             return {
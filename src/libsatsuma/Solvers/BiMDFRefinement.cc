@@ -9,7 +9,11 @@
 #include <libsatsuma/Reductions/BiMCF_to_BMatching.hh>
 #include <libsatsuma/Reductions/BMatching_to_Matching.hh>
 #include <libsatsuma/Reductions/BiMDF_Simplification.hh>
+#include <libsatsuma/Reductions/BiMDF_Restriction.hh>
 #include <libsatsuma/Exceptions.hh>
+#include <libsatsuma/Extra/Parallel.hh>
+#include <lemon/maps.h>
+#include <deque>
 
 #if SATSUMA_HAVE_GUROBI
 #  include <libsatsuma/Solvers/BiMCFGurobi.hh> // just for testing
@@ -21,11 +25,13 @@ BiMDFRefinementResult refine_with_matching(const BiMDF &_bimdf,
                                            BiMDF::Solution const& f0,
                                            int max_deviation,
                                            DeviationLimitKind deviation_limit,
-                                           MatchingSolver matching_solver)
+                                           MatchingSolver matching_solver,
+                                           BiMDF::EdgeMap<int> const *max_edge_deviation)
 {
     auto red_bimcf = BiMDF_to_BiMCF(_bimdf, {
         .guess = f0,
-        .max_deviation = max_deviation,
+        .max_deviation = static_cast<BiMDF::FlowScalar>(max_deviation),
+        .max_edge_deviation = max_edge_deviation,
         .last_arc_uncapacitated = false, // matching is not compatible with uncapacitated arcs
         .even = false,
         .consolidate = true});
@@ -43,7 +49,8 @@ BiMDFRefinementResult refine_with_matching(const BiMDF &_bimdf,
     auto red_bmatching = BiMCF_to_BMatching(red_bimcf.bimcf(), {
             .max_deviation = max_deviation,
             .deviation_limit = deviation_limit});
-    auto red_matching = BMatching_to_Matching(red_bmatching.bmatching());
+    auto red_matching = BMatching_to_Matching(red_bmatching.bmatching(), {
+            .max_scaled_weight = matching_weight_limit(matching_solver)});
 
     auto sol_matching = solve_matching(red_matching.matching(), matching_solver);
     auto sol_bmatching = red_matching.translate_solution(sol_matching);
@@ -55,5 +62,248 @@ BiMDFRefinementResult refine_with_matching(const BiMDF &_bimdf,
 
 }
 
+size_t estimate_refinement_memory(const BiMDF &_bimdf, int max_deviation)
+{
+    // Each BiMDF edge yields up to two BiMCF edges (one per direction) of capacity
+    // max_deviation, each BMatching node has degree at most max_deviation.
+    // BMatching_to_Matching then creates up to degree^2 matching edges per
+    // b-matching edge and `degree` matching nodes per b-matching node.
+    // Per-element sizes roughly account for the graph, maps and matching solver state.
+    const size_t d = std::max(max_deviation, 0);
+    const size_t n_bm_nodes = 2 * _bimdf.n_nodes();
+    const size_t n_bm_edges = _bimdf.n_nodes() + 2 * _bimdf.n_edges();
+    const size_t n_matching_nodes = n_bm_nodes * d + 4 * _bimdf.n_edges() * d;
+    const size_t n_matching_edges = n_bm_edges * d * d;
+    const size_t bytes_per_node = 128;
+    const size_t bytes_per_edge = 96;
+    return n_matching_nodes * bytes_per_node + n_matching_edges * bytes_per_edge;
+}
+
+std::unique_ptr<BiMDF::EdgeMap<int>> deviation_windows(const BiMDF &_bimdf,
+                                                       BiMDF::Solution const& sol,
+                                                       int max_deviation,
+                                                       BiMDF::CostScalar pin_cost)
+{
+    const auto &g = _bimdf.g;
+    auto windows = std::make_unique<BiMDF::EdgeMap<int>>(g, max_deviation);
+    for (const auto e: g.edges()) {
+        const auto x = sol[e];
+        const auto lo = std::max<BiMDF::FlowScalar>(x - max_deviation, _bimdf.lower[e]);
+        const auto hi = std::min<BiMDF::FlowScalar>(x + max_deviation, _bimdf.upper[e]);
+        const auto cost_x = _bimdf.cost(e, x);
+        // closest minimizer within the window:
+        auto argmin = x;
+        auto min_cost = cost_x;
+        for (int d = 1; d <= max_deviation; ++d) {
+            for (const auto y: {x - d, x + d}) {
+                if (y < lo || y > hi) {
+                    continue;
+                }
+                auto c = _bimdf.cost(e, y);
+                if (c < min_cost) {
+                    min_cost = c;
+                    argmin = y;
+                }
+            }
+        }
+        if (argmin == x) {
+            bool pinned = (x <= lo || _bimdf.cost(e, x - 1) - cost_x >= pin_cost)
+                       && (x >= hi || _bimdf.cost(e, x + 1) - cost_x >= pin_cost);
+            (*windows)[e] = pinned ? 0 : 1;
+        } else {
+            (*windows)[e] = static_cast<int>(std::min<BiMDF::FlowScalar>(max_deviation, std::abs(argmin - x) + 1));
+        }
+    }
+    return windows;
+}
+
+BiMDFRefinementResult refine_with_matching_restricted(const BiMDF &_bimdf,
+                                                      BiMDF::Solution const& f0,
+                                                      BiMDF::EdgeMap<bool> const& active,
+                                                      int max_deviation,
+                                                      DeviationLimitKind deviation_limit,
+                                                      MatchingSolver matching_solver)
+{
+    BiMDF_Restriction restriction(_bimdf, active, f0);
+    const auto &sub = restriction.bimdf();
+    if (sub.n_edges() == 0) {
+        auto sol = std::make_unique<BiMDF::Solution>(_bimdf.g);
+        lemon::mapCopy(_bimdf.g, f0, *sol);
+        return {.sol = std::move(sol), .cost_change = 0};
+    }
+    auto sub_f0 = restriction.restrict_solution(f0);
+    auto sub_res = refine_with_matching(sub, *sub_f0, max_deviation,
+                                        deviation_limit, matching_solver);
+    auto res = restriction.translate_solution({.solution = std::move(sub_res.sol)});
+    return {.sol = std::move(res.solution),
+            .cost_change = sub_res.cost_change};
+}
+
+std::unique_ptr<BiMDF::EdgeMap<bool>> refinement_frontier(const BiMDF &_bimdf,
+                                                          BiMDF::Solution const& f0,
+                                                          BiMDF::Solution const& f1,
+                                                          int hops)
+{
+    const auto &g = _bimdf.g;
+    auto active = std::make_unique<BiMDF::EdgeMap<bool>>(g, false);
+    BiMDF::NodeMap<int> dist{g, -1};
+    std::deque<BiMDF::Node> queue;
+    auto add_seed = [&](BiMDF::Node n) {
+        if (dist[n] == -1) {
+            dist[n] = 0;
+            queue.push_back(n);
+        }
+    };
+    for (const auto e: g.edges()) {
+        if (f0[e] != f1[e]) {
+            add_seed(g.u(e));
+            add_seed(g.v(e));
+        }
+    }
+    while (!queue.empty()) {
+        auto n = queue.front();
+        queue.pop_front();
+        for (const auto a: g.outArcs(n)) {
+            (*active)[a] = true;
+            auto other = g.target(a);
+            if (dist[n] + 1 < hops && dist[other] == -1) {
+                dist[other] = dist[n] + 1;
+                queue.push_back(other);
+            }
+        }
+    }
+    return active;
+}
+
+std::unique_ptr<BiMDF::EdgeMap<bool>> reduced_cost_candidates(const BiMDF &_bimdf,
+                                                              BiMDF::Solution const& sol,
+                                                              std::vector<MCF::CostScalar> const& potential,
+                                                              double potential_multiplier,
+                                                              BiMDF::CostScalar threshold)
+{
+    auto red_bimcf = BiMDF_to_BiMCF(_bimdf, {
+        .guess = sol,
+        .max_deviation = 1,
+        .last_arc_uncapacitated = false,
+        .even = false,
+        .consolidate = true});
+    auto red_mcf = BiMCF_to_MCF(red_bimcf.bimcf(), {
+        .method = BiMCF_to_MCF::Method::NotEven});
+    const auto &mcf = red_mcf.mcf();
+    const auto &g = mcf.g;
+    // both are powers of two, usually equal
+    const double potential_scale = red_mcf.cost_multiplier() / potential_multiplier;
+    auto pi = [&](MCF::Node n) -> MCF::CostScalar {
+        const size_t id = g.id(n);
+        if (id >= potential.size()) {
+            return 0;
+        }
+        return potential_scale == 1.
+            ? potential[id]
+            : static_cast<MCF::CostScalar>(std::llround(potential[id] * potential_scale));
+    };
+    const auto scaled_threshold = threshold * red_mcf.cost_multiplier();
+
+    auto active = std::make_unique<BiMDF::EdgeMap<bool>>(_bimdf.g, false);
+    for (const auto a: g.arcs()) {
+        auto reduced_cost = mcf.cost[a] + pi(g.source(a)) - pi(g.target(a));
+        if (reduced_cost < scaled_threshold) {
+            auto e = red_bimcf.orig_bimdf_edge(red_mcf.orig_bimcf_edge(a));
+            (*active)[e] = true;
+        }
+    }
+    return active;
+}
+
+std::vector<std::vector<BiMDF::Edge>> bfs_edge_regions(const BiMDF &_bimdf,
+                                                       size_t n_regions,
+                                                       BiMDF::Node seed)
+{
+    const auto &g = _bimdf.g;
+    const size_t n_edges = _bimdf.n_edges();
+    const size_t target_size = (n_edges + n_regions - 1) / std::max<size_t>(n_regions, 1);
+
+    std::vector<std::vector<BiMDF::Edge>> regions(1);
+    regions.back().reserve(target_size);
+    BiMDF::EdgeMap<bool> assigned{g, false};
+    BiMDF::NodeMap<bool> visited{g, false};
+    std::deque<BiMDF::Node> queue;
+    auto grow_from = [&](BiMDF::Node start) {
+        visited[start] = true;
+        queue.push_back(start);
+        while (!queue.empty()) {
+            auto n = queue.front();
+            queue.pop_front();
+            for (const auto a: g.outArcs(n)) {
+                const BiMDF::Edge e = a;
+                if (!assigned[e]) {
+                    assigned[e] = true;
+                    if (regions.back().size() >= target_size) {
+                        regions.emplace_back();
+                        regions.back().reserve(target_size);
+                    }
+                    regions.back().push_back(e);
+                }
+                auto other = g.target(a);
+                if (!visited[other]) {
+                    visited[other] = true;
+                    queue.push_back(other);
+                }
+            }
+        }
+    };
+    grow_from(seed);
+    for (const auto n: g.nodes()) {
+        if (!visited[n]) {
+            grow_from(n);
+        }
+    }
+    return regions;
+}
+
+BiMDFRefinementResult refine_regions_with_matching(const BiMDF &_bimdf,
+                                                   BiMDF::Solution const& f0,
+                                                   std::vector<std::vector<BiMDF::Edge>> const& regions,
+                                                   int max_deviation,
+                                                   DeviationLimitKind deviation_limit,
+                                                   MatchingSolver matching_solver,
+                                                   unsigned n_threads)
+{
+    const auto &g = _bimdf.g;
+    BiMDF::EdgeMap<size_t> region_id{g, regions.size()};
+    for (size_t r = 0; r < regions.size(); ++r) {
+        for (const auto e: regions[r]) {
+            region_id[e] = r;
+        }
+    }
+    auto sol = std::make_unique<BiMDF::Solution>(g);
+    lemon::mapCopy(g, f0, *sol);
+    std::vector<BiMDF::CostScalar> cost_changes(regions.size(), 0.);
+
+    parallel_for(regions.size(), n_threads, [&](size_t r) {
+        if (regions[r].empty()) {
+            return;
+        }
+        BiMDF_Restriction restriction(_bimdf, regions[r],
+                [&](BiMDF::Edge e){return region_id[e] == r;},
+                f0);
+        auto sub_f0 = restriction.restrict_solution(f0);
+        auto sub_res = refine_with_matching(restriction.bimdf(), *sub_f0, max_deviation,
+                                            deviation_limit, matching_solver);
+        if (sub_res.cost_change < 0) {
+            // regions are edge-disjoint, so concurrent writes do not overlap.
+            restriction.apply_solution(*sub_res.sol, *sol);
+            cost_changes[r] = sub_res.cost_change;
+        }
+    });
+
+    BiMDF::CostScalar cost_change = 0;
+    for (const auto c: cost_changes) {
+        cost_change += c;
+    }
+    return {.sol = std::move(sol),
+            .cost_change = cost_change};
+}
+
 
 } // namespace Satsuma
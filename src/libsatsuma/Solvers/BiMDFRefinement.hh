@@ -18,10 +18,71 @@ struct BiMDFRefinementResult {
     BiMDF::CostScalar cost_change;
 };
 
+/// If `max_edge_deviation` is given, it limits the change of each edge individually
+/// (see deviation_windows), `max_change` still limits the node throughflow.
 BiMDFRefinementResult refine_with_matching(const BiMDF &_orig,
                                            BiMDF::Solution const& f0,
                                            int max_change,
                                            DeviationLimitKind deviation_limit = DeviationLimitKind::Default,
-                                           MatchingSolver matching_solver = MatchingSolver::Default);
+                                           MatchingSolver matching_solver = MatchingSolver::Default,
+                                           BiMDF::EdgeMap<int> const *max_edge_deviation = nullptr);
+
+/// Rough upper bound on the memory (in bytes) used by the matching problem of
+/// refine_with_matching with `max_deviation`, without building it.
+size_t estimate_refinement_memory(const BiMDF &_bimdf, int max_deviation);
+
+/// Per-edge deviation windows of width at most `max_deviation` for refinement of `sol`.
+/// An edge gets a window that reaches one unit past the minimizer of its cost
+/// within [sol-max_deviation, sol+max_deviation]; edges at that minimizer whose unit moves
+/// both cost at least `pin_cost` are pinned (window width 0).
+/// Bounds are respected by BiMDF_to_BiMCF anyway.
+std::unique_ptr<BiMDF::EdgeMap<int>> deviation_windows(const BiMDF &_bimdf,
+                                                       BiMDF::Solution const& sol,
+                                                       int max_deviation,
+                                                       BiMDF::CostScalar pin_cost);
+
+/// Like refine_with_matching, but only edges with `active[e]` may change their flow,
+/// the refinement problem is built on the active edges only.
+BiMDFRefinementResult refine_with_matching_restricted(const BiMDF &_orig,
+                                                      BiMDF::Solution const& f0,
+                                                      BiMDF::EdgeMap<bool> const& active,
+                                                      int max_change,
+                                                      DeviationLimitKind deviation_limit = DeviationLimitKind::Default,
+                                                      MatchingSolver matching_solver = MatchingSolver::Default);
+
+/// Edges that are at most `hops` hops away from an edge on which `f0` and `f1` differ:
+/// with hops=1, all edges incident to an endpoint of a changed edge.
+std::unique_ptr<BiMDF::EdgeMap<bool>> refinement_frontier(const BiMDF &_bimdf,
+                                                          BiMDF::Solution const& f0,
+                                                          BiMDF::Solution const& f1,
+                                                          int hops);
+
+/// Reduced-cost fixing: edges for which some unit change of flow has a reduced cost
+/// below `threshold` w.r.t. the double cover node `potential`
+/// (indexed by double cover node id, e.g. from approximate_bimdf_doublecover),
+/// which are integer costs scaled by `potential_multiplier`.
+/// The other edges are unlikely to change in refinement and can be kept fixed,
+/// this is a heuristic unless `potential` is an optimal dual.
+std::unique_ptr<BiMDF::EdgeMap<bool>> reduced_cost_candidates(const BiMDF &_bimdf,
+                                                              BiMDF::Solution const& sol,
+                                                              std::vector<MCF::CostScalar> const& potential,
+                                                              double potential_multiplier,
+                                                              BiMDF::CostScalar threshold);
+
+/// Partition the edges of `_bimdf` into at most `n_regions` regions of balanced size
+/// by growing them in BFS order from `seed`.
+std::vector<std::vector<BiMDF::Edge>> bfs_edge_regions(const BiMDF &_bimdf,
+                                                       size_t n_regions,
+                                                       BiMDF::Node seed);
+
+/// Refine all `regions` concurrently, each with the flows outside of it fixed to `f0`.
+/// Regions must be pairwise edge-disjoint, so their changes can be combined.
+BiMDFRefinementResult refine_regions_with_matching(const BiMDF &_orig,
+                                                   BiMDF::Solution const& f0,
+                                                   std::vector<std::vector<BiMDF::Edge>> const& regions,
+                                                   int max_change,
+                                                   DeviationLimitKind deviation_limit = DeviationLimitKind::Default,
+                                                   MatchingSolver matching_solver = MatchingSolver::Default,
+                                                   unsigned n_threads = 0);
 
 } // namespace Satsuma
@@ -0,0 +1,198 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include <libsatsuma/Solvers/BiMDFUnicyclic.hh>
+#include <libsatsuma/Exceptions.hh>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+namespace Satsuma {
+
+namespace {
+/// a + b * t
+struct Affine {
+    int64_t a = 0;
+    int64_t b = 0;
+    Affine& operator+=(Affine const &o) {a += o.a; b += o.b; return *this;}
+    Affine operator*(int64_t s) const {return {a * s, b * s};}
+    int64_t operator()(int64_t t) const {return a + b * t;}
+};
+
+int64_t floor_div(int64_t x, int64_t y) {
+    auto q = x / y;
+    return (x % y != 0 && ((x < 0) != (y < 0))) ? q - 1 : q;
+}
+int64_t ceil_div(int64_t x, int64_t y) {
+    return -floor_div(-x, y);
+}
+} // namespace
+
+BiMDFResult solve_bimdf_unicyclic(const BiMDF &_bimdf)
+{
+    const auto &g = _bimdf.g;
+    if (bimdf_cyclomatic_number(_bimdf) > 1) {
+        throw std::invalid_argument("solve_bimdf_unicyclic: cyclomatic number > 1");
+    }
+    auto sign_at = [&](BiMDF::Arc a) -> int64_t {
+        // contribution of the edge of `a` to the balance of its source node, per unit of flow
+        const BiMDF::Edge e = a;
+        bool head = g.direction(a) ? _bimdf.u_head[e] : _bimdf.v_head[e];
+        return head ? 1 : -1;
+    };
+
+    // spanning tree by BFS, the remaining edge (if any) carries the parameter t.
+    BiMDF::EdgeMap<bool> in_tree{g, false};
+    BiMDF::NodeMap<bool> reached{g, false};
+    BiMDF::NodeMap<int> tree_degree{g, 0};
+    size_t n_reached = 0;
+    if (g.nodes().begin() != g.nodes().end()) {
+        std::deque<BiMDF::Node> queue{*g.nodes().begin()};
+        reached[queue.front()] = true;
+        while (!queue.empty()) {
+            auto n = queue.front();
+            queue.pop_front();
+            ++n_reached;
+            for (const auto a: g.outArcs(n)) {
+                auto m = g.target(a);
+                if (!reached[m]) {
+                    reached[m] = true;
+                    in_tree[BiMDF::Edge(a)] = true;
+                    ++tree_degree[n];
+                    ++tree_degree[m];
+                    queue.push_back(m);
+                }
+            }
+        }
+    }
+    if (n_reached != _bimdf.n_nodes()) {
+        throw std::invalid_argument("solve_bimdf_unicyclic: graph is not connected");
+    }
+
+    BiMDF::EdgeMap<Affine> flow{g};
+    BiMDF::NodeMap<Affine> balance{g}; // contributions of already determined edges
+    for (const auto e: g.edges()) {
+        if (in_tree[e]) {
+            continue;
+        }
+        flow[e] = {0, 1};
+        balance[g.u(e)] += flow[e] * (_bimdf.u_head[e] ? 1 : -1);
+        balance[g.v(e)] += flow[e] * (_bimdf.v_head[e] ? 1 : -1);
+    }
+
+    // peel leaves of the spanning tree
+    BiMDF::EdgeMap<bool> determined{g, false};
+    std::deque<BiMDF::Node> leaves;
+    for (const auto n: g.nodes()) {
+        if (tree_degree[n] == 1) {
+            leaves.push_back(n);
+        }
+    }
+    BiMDF::Node root = g.nodes().begin() != g.nodes().end() ? *g.nodes().begin() : lemon::INVALID;
+    size_t n_peeled = 0;
+    while (!leaves.empty() && n_peeled + 1 < _bimdf.n_nodes()) {
+        auto n = leaves.front();
+        leaves.pop_front();
+        if (tree_degree[n] != 1) {
+            continue;
+        }
+        for (const auto a: g.outArcs(n)) {
+            const BiMDF::Edge e = a;
+            if (!in_tree[e] || determined[e]) {
+                continue;
+            }
+            // balance[n] + sign * x = demand[n]
+            auto s = sign_at(a);
+            Affine rest = balance[n] * -1;
+            rest.a += _bimdf.demand[n];
+            flow[e] = rest * s;
+            determined[e] = true;
+            auto m = g.target(a);
+            balance[m] += flow[e] * sign_at(g.oppositeArc(a));
+            tree_degree[n] = 0;
+            if (--tree_degree[m] == 1) {
+                leaves.push_back(m);
+            }
+            root = m;
+            break;
+        }
+        ++n_peeled;
+    }
+
+    // conservation at the root: balance[root](t) == demand[root]
+    int64_t t_lo = -(int64_t{1} << 30);
+    int64_t t_hi = (int64_t{1} << 30);
+    if (root != lemon::INVALID) {
+        const auto &b = balance[root];
+        const int64_t rhs = _bimdf.demand[root] - b.a;
+        if (b.b == 0) {
+            if (rhs != 0) {
+                throw InfeasibleError("solve_bimdf_unicyclic: demands can not be satisfied");
+            }
+        } else {
+            if (rhs % b.b != 0) {
+                throw InfeasibleError("solve_bimdf_unicyclic: no integral solution");
+            }
+            t_lo = t_hi = rhs / b.b;
+        }
+    }
+    for (const auto e: g.edges()) {
+        const auto &f = flow[e];
+        const int64_t lower = _bimdf.lower[e];
+        const int64_t upper = _bimdf.upper[e];
+        if (f.b == 0) {
+            if (f.a < lower || (upper != BiMDF::inf() && f.a > upper)) {
+                throw InfeasibleError("solve_bimdf_unicyclic: bounds violated");
+            }
+        } else if (f.b > 0) {
+            t_lo = std::max(t_lo, ceil_div(lower - f.a, f.b));
+            if (upper != BiMDF::inf()) {
+                t_hi = std::min(t_hi, floor_div(upper - f.a, f.b));
+            }
+        } else {
+            t_hi = std::min(t_hi, floor_div(lower - f.a, f.b));
+            if (upper != BiMDF::inf()) {
+                t_lo = std::max(t_lo, ceil_div(upper - f.a, f.b));
+            }
+        }
+    }
+    if (t_lo > t_hi) {
+        throw InfeasibleError("solve_bimdf_unicyclic: bounds violated");
+    }
+
+    auto cycle_cost = [&](int64_t t) {
+        BiMDF::CostScalar cost = 0;
+        for (const auto e: g.edges()) {
+            if (flow[e].b != 0) {
+                cost += _bimdf.cost(e, static_cast<double>(flow[e](t)));
+            }
+        }
+        return cost;
+    };
+    // smallest t with non-negative slope (convexity)
+    int64_t lo = t_lo;
+    int64_t hi = t_hi;
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (cycle_cost(mid + 1) - cycle_cost(mid) >= 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    const auto t = lo;
+
+    auto sol = std::make_unique<BiMDF::Solution>(g);
+    for (const auto e: g.edges()) {
+        (*sol)[e] = static_cast<BiMDF::FlowScalar>(flow[e](t));
+    }
+    if (!_bimdf.is_valid(*sol)) {
+        throw InternalError("solve_bimdf_unicyclic: result infeasible");
+    }
+    auto cost = _bimdf.cost(*sol);
+    return {.solution = std::move(sol),
+            .cost = cost};
+}
+
+} // namespace Satsuma
@@ -0,0 +1,26 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <libsatsuma/Problems/BiMDF.hh>
+
+namespace Satsuma {
+
+/// Cyclomatic number m - n + 1 of a connected BiMDF, i.e. the dimension of its cycle space.
+inline long bimdf_cyclomatic_number(const BiMDF &_bimdf) {
+    return static_cast<long>(_bimdf.n_edges()) - static_cast<long>(_bimdf.n_nodes()) + 1;
+}
+
+/// Exact solver for connected BiMDFs with cyclomatic number at most 1.
+///
+/// All flows are affine functions of the flow t on a single non-tree edge,
+/// obtained by peeling leaves of a spanning tree. For a tree,
+/// conservation fixes all flows; if the cycle is unbalanced (an odd number of
+/// edge ends with equal orientation), conservation at the last node fixes t;
+/// otherwise t is found by a binary search on the slope of the convex cost along the cycle.
+///
+/// Throws InfeasibleError if there is no feasible integral flow,
+/// std::invalid_argument for disconnected or higher-cyclomatic inputs.
+BiMDFResult solve_bimdf_unicyclic(const BiMDF &_bimdf);
+
+} // namespace Satsuma
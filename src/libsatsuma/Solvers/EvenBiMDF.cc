@@ -2,6 +2,7 @@
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Solvers/EvenBiMDF.hh>
 #include <libsatsuma/Problems/TJoin.hh>
+#include <libsatsuma/Problems/HomogeneousCosts.hh>
 #include <libsatsuma/Solvers/TJoinMST.hh>
 #include <libsatsuma/Exceptions.hh>
 #include <lemon/maps.h>
@@ -9,6 +10,7 @@
 namespace Satsuma {
 
 /// return cheapest +/- 1 adjusted target length and the cost of the change
+template<typename CostT>
 static
 std::pair<BiMDF::FlowScalar, BiMDF::CostScalar>
 find_best_adjustment(BiMDF const&_bimdf, BiMDF::Edge e, BiMDF::TargetScalar initial)
@@ -22,7 +24,7 @@ find_best_adjustment(BiMDF const&_bimdf, BiMDF::Edge e, BiMDF::TargetScalar init
     if (guess > upper) {
         guess = upper;
     }
-    const auto base_cost = _bimdf.cost(e, guess);
+    const auto base_cost = edge_cost<CostT>(_bimdf, e, guess);
     auto best_cost = std::numeric_limits<BiMDF::CostScalar>::infinity();
     auto best_guess = guess;
     for (int adj = -1; adj<=1; adj+=2)
@@ -32,7 +34,7 @@ find_best_adjustment(BiMDF const&_bimdf, BiMDF::Edge e, BiMDF::TargetScalar init
         if (x < lower || x > upper) {
             continue;
         }
-        auto cost_change = _bimdf.cost(e, x) - base_cost;
+        auto cost_change = edge_cost<CostT>(_bimdf, e, x) - base_cost;
         if (cost_change < best_cost) {
             best_cost = cost_change;
             best_guess = x;
@@ -48,7 +50,8 @@ find_best_adjustment(BiMDF const&_bimdf, BiMDF::Edge e, BiMDF::TargetScalar init
     return {best_guess, best_cost};
 }
 
-EveningResult round_to_even(const BiMDF &bimdf)
+template<typename CostT>
+static EveningResult round_to_even_impl(const BiMDF &bimdf)
 {
     auto guessp = std::make_unique<BiMDF::Guess>(bimdf.g);
 
@@ -59,7 +62,7 @@ EveningResult round_to_even(const BiMDF &bimdf)
     {
         const auto lower = bimdf.lower[e];
         const auto upper = bimdf.upper[e];
-        BiMDF::FlowScalar guess = std::llround(bimdf.guess(e));
+        BiMDF::FlowScalar guess = std::llround(edge_guess<CostT>(bimdf, e));
         if (guess < lower) {
             guess = lower;
         } else if (guess > upper) {
@@ -67,7 +70,7 @@ EveningResult round_to_even(const BiMDF &bimdf)
         }
 
         if (guess & 1) {
-            auto adj = find_best_adjustment(bimdf, e, guess);
+            auto adj = find_best_adjustment<CostT>(bimdf, e, guess);
             guess = adj.first;
             cost += adj.second;
             ++n_adjustments;
@@ -85,14 +88,32 @@ EveningResult round_to_even(const BiMDF &bimdf)
     };
 }
 
+EveningResult round_to_even(const BiMDF &bimdf)
+{
+    return with_homogeneous_cost_type(bimdf, [&](auto cost_type) {
+        return round_to_even_impl<typename decltype(cost_type)::type>(bimdf);
+    });
+}
+
 
 
 EveningResult TJoinBasedRounding::solve()
+{
+    return with_homogeneous_cost_type(bimdf_, [&](auto cost_type) {
+        return solve_impl<typename decltype(cost_type)::type>();
+    });
+}
+
+template<typename CostT>
+EveningResult TJoinBasedRounding::solve_impl()
 {
     const auto &g = bimdf_.g;
     auto guessp = std::make_unique<BiMDF::Guess>(g);
     auto &guess = *guessp;
 
+    for (const auto n: g.nodes()) {
+        rhs_[n] = -bimdf_.demand[n];
+    }
 
     for (const auto e: g.edges())
     {
@@ -104,13 +125,15 @@ EveningResult TJoinBasedRounding::solve()
         // TODO: use find_best_adjustment
         auto lower = bimdf_.lower[e];
         auto upper = bimdf_.upper[e];
-        auto opti = std::llround(bimdf_.guess(e));
+        auto opti = std::llround(edge_guess<CostT>(bimdf_, e));
         auto rounded = opti;
         if (rounded < lower) {
             rounded = lower;
+        } else if (rounded > upper) {
+            rounded = upper;
         }
         guess[e] = rounded;
-        auto base_cost = bimdf_.cost(e, rounded);
+        auto base_cost = edge_cost<CostT>(bimdf_, e, rounded);
         cost_[e] = std::numeric_limits<double>::infinity();
         for (int adj = -1; adj<=1; adj+=2)
         {
@@ -119,7 +142,7 @@ EveningResult TJoinBasedRounding::solve()
             if (x < lower || x > upper) {
                 continue;
             }
-            auto cost_change = bimdf_.cost(e, x) - base_cost;
+            auto cost_change = edge_cost<CostT>(bimdf_, e, x) - base_cost;
             if (cost_change < cost_[e]) {
                 cost_[e] = cost_change;
                 adjusted_guess_[e] = x;
@@ -150,8 +173,8 @@ EveningResult TJoinBasedRounding::solve()
     for (const auto e: g.edges()) {
         if (sol[e]) {
             guess[e] = adjusted_guess_[e];
-            auto opti = std::llround(bimdf_.guess(e));
-            cost += bimdf_.cost(e, guess[e]) - bimdf_.cost(e, opti);
+            auto opti = std::llround(edge_guess<CostT>(bimdf_, e));
+            cost += edge_cost<CostT>(bimdf_, e, guess[e]) - edge_cost<CostT>(bimdf_, e, opti);
             ++n_adjustments;
         }
     }
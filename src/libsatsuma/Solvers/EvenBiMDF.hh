@@ -44,6 +44,10 @@ public:
     TJoin const& tjoin() const {return tjoin_;}
 
 private:
+    /// solve() for cost functions of type CostT, see with_homogeneous_cost_type
+    template<typename CostT>
+    EveningResult solve_impl();
+
     BiMDF const& bimdf_;
     int verbosity_;
     BiMDF::EdgeMap<TJoin::CostScalar> cost_;
@@ -28,7 +28,11 @@ MCFResult solve_mcf_via_lemon_netsimp(const MCF &mcf)
     for (const auto a: mcf.g.arcs()) {
         (*sol)[a] = solver.flow(a);
     }
-    return {.solution = std::move(sol), .cost = solver.totalCost()};
+    auto potential = std::make_unique<MCF::NodeMap<MCF::CostScalar>>(mcf.g);
+    solver.potentialMap(*potential);
+    return {.solution = std::move(sol),
+            .cost = solver.totalCost(),
+            .potential = std::move(potential)};
 }
 
 
@@ -2,7 +2,11 @@
 //  SPDX-License-Identifier: MIT
 #include <libsatsuma/Solvers/Matching.hh>
 #include <libsatsuma/Config/Blossom5.hh>
+#include <libsatsuma/Exceptions.hh>
+#include <libsatsuma/Problems/CostScaling.hh>
 #include <lemon/matching.h>
+#include <cstdlib>
+#include <limits>
 
 #if SATSUMA_HAVE_BLOSSOM5
 #  include <blossom5/PerfectMatching.h>
@@ -48,7 +52,10 @@ MatchingResult solve_matching_via_blossomV(Matching const &mp)
 
     // TODO: Blossom allows updates to the input for warmstart!
     for (auto e: g.edges()) {
-        int cost = -mp.weight[e];
+        if (std::abs(mp.weight[e]) > std::numeric_limits<int>::max()) {
+            throw CostOverflowError("blossom-V: edge weight exceeds int range");
+        }
+        int cost = static_cast<int>(-mp.weight[e]);
         auto u = g.id(g.u(e));
         auto v = g.id(g.v(e));
         assert(u != v);
@@ -85,6 +92,14 @@ MatchingResult solve_matching_via_blossomV(Matching const &mp)
 }
 #endif
 
+double matching_weight_limit(MatchingSolver solver)
+{
+    if (solver == MatchingSolver::BlossomV) {
+        return std::numeric_limits<int>::max();
+    }
+    return CostScaling::default_limit;
+}
+
 MatchingResult solve_matching(const Matching &mp, MatchingSolver solver)
 {
    switch (solver)
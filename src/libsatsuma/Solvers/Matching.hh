@@ -15,4 +15,8 @@ MatchingResult solve_matching_via_lemon(Matching const &mp);
 /// The matching problem must be feasible, otherwise Blossom-V warns of undefined behaviour!
 MatchingResult solve_matching_via_blossomV(Matching const &mp);
 
+/// Largest absolute weight `solver` handles, for CostScaling:
+/// Blossom-V uses int weights, Lemon 64 bits.
+double matching_weight_limit(MatchingSolver solver);
+
 } // namespace Satsuma
@@ -0,0 +1,204 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include "test_problems.hh"
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Reductions/BiMDF_Simplification.hh>
+#include <libsatsuma/Solvers/BiMDFUnicyclic.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+
+using namespace Satsuma;
+using namespace Satsuma::TestProblems;
+
+class ComponentsTest : public TriangleBicycleTest {};
+
+TEST(UnicyclicTest, tree_cycle_and_unbalanced_cycle)
+{
+    auto abs = [](double target) {
+        return CostFunction::AbsDeviation{.target = target, .weight = 1.};
+    };
+    {
+        // path a -> b, fixed by demands
+        BiMDF tree;
+        auto a = tree.add_node(-3);
+        auto b = tree.add_node(3);
+        auto e = tree.add_edge({.u = a, .v = b, .u_head = false, .v_head = true, .cost_function = abs(1)});
+        auto res = solve_bimdf_unicyclic(tree);
+        EXPECT_EQ((*res.solution)[e], 3);
+        EXPECT_DOUBLE_EQ(res.cost, 2.);
+    }
+    {
+        // directed triangle, balanced: one degree of freedom
+        BiMDF cycle;
+        auto a = cycle.add_node();
+        auto b = cycle.add_node();
+        auto c = cycle.add_node();
+        cycle.add_edge({.u = a, .v = b, .u_head = false, .v_head = true, .cost_function = abs(3)});
+        cycle.add_edge({.u = b, .v = c, .u_head = false, .v_head = true, .cost_function = abs(5)});
+        cycle.add_edge({.u = c, .v = a, .u_head = false, .v_head = true, .cost_function = abs(4)});
+        EXPECT_EQ(bimdf_cyclomatic_number(cycle), 1);
+        auto res = solve_bimdf_unicyclic(cycle);
+        EXPECT_TRUE(cycle.is_valid(*res.solution));
+        EXPECT_DOUBLE_EQ(res.cost, 2.);
+        for (const auto e: cycle.g.edges()) {
+            EXPECT_EQ((*res.solution)[e], 4);
+        }
+
+        // solve_bimdf takes the fast path: no double cover, no refinement
+        BiMDFSolverConfig config;
+        config.verbosity = 0;
+        config.double_cover.verbosity = 0;
+        auto res_fast = solve_bimdf(cycle, config);
+        ASSERT_EQ(res_fast.cc_info.size(), 1u);
+        EXPECT_DOUBLE_EQ(res_fast.cc_info[0].double_cover.cost, 0.);
+        EXPECT_TRUE(res_fast.cc_info[0].matching.cost_changes.empty());
+        EXPECT_DOUBLE_EQ(res_fast.cost, 2.);
+        config.low_cyclomatic_fast_path = false;
+        auto res_dc = solve_bimdf(cycle, config);
+        EXPECT_GT(res_dc.cc_info[0].double_cover.cost, 0.);
+    }
+    {
+        // unbalanced self-loop (two tails): conservation fixes the flow
+        BiMDF loop;
+        auto a = loop.add_node(-4);
+        auto e = loop.add_edge({.u = a, .v = a, .u_head = false, .v_head = false, .cost_function = abs(0)});
+        auto res = solve_bimdf_unicyclic(loop);
+        EXPECT_EQ((*res.solution)[e], 2);
+    }
+}
+
+TEST_F(ComponentsTest, packed_components_match_separate)
+{
+    // several copies of the fixture, plus a directed 2-cycle for the fast path
+    BiMDF copies;
+    const int n_copies = 4;
+    for (int i = 0; i < n_copies; ++i) {
+        add_copy(copies, bimdf);
+    }
+    auto a = copies.add_node();
+    auto b = copies.add_node();
+    copies.add_edge({.u = a, .v = b, .u_head = false, .v_head = true,
+                     .cost_function = CostFunction::AbsDeviation{.target = 2, .weight = 1.}});
+    copies.add_edge({.u = b, .v = a, .u_head = false, .v_head = true,
+                     .cost_function = CostFunction::AbsDeviation{.target = 4, .weight = 1.}});
+
+    config.pack_components_below_edges = 10;
+    auto res = solve_bimdf(copies, config);
+    ASSERT_TRUE(copies.is_valid(*res.solution));
+    EXPECT_DOUBLE_EQ(res.cost, n_copies * 2. + 2.);
+    // packed copies plus the separate 2-cycle
+    ASSERT_EQ(res.cc_info.size(), 2u);
+    EXPECT_EQ(res.cc_info[0].n_edges + res.cc_info[1].n_edges, copies.n_edges());
+}
+
+TEST_F(ComponentsTest, deduplicate_relabeled_components)
+{
+    // the triangle edge a->b counts the evaluations of all copies
+    auto counter = std::make_shared<CountingAbs>(3.);
+    const auto counted = bimdf.g.edgeFromId(0);
+    bimdf.cost_function[counted] = CostFunction::VirtualObjective{.obj_ = counter};
+    solve_bimdf(bimdf, config);
+    const size_t n_single = counter->n_evaluations;
+    ASSERT_GT(n_single, 0u);
+
+    // copies of the fixture with permuted nodes and edges and swapped edge ends,
+    // the last one with a different target instead of the counter
+    BiMDF copies;
+    const int n_copies = 4;
+    std::vector<BiMDF::EdgeInfo> infos;
+    for (const auto e: bimdf.g.edges()) {
+        infos.push_back(bimdf.get_edge_info(e));
+    }
+    for (int i = 0; i < n_copies; ++i) {
+        std::vector<BiMDF::Node> nodes(bimdf.n_nodes());
+        for (int j = 0; j < static_cast<int>(nodes.size()); ++j) {
+            nodes[(j + i) % nodes.size()] = copies.add_node();
+        }
+        for (size_t j = 0; j < infos.size(); ++j) {
+            auto ei = infos[(j + i) % infos.size()];
+            ei.u = nodes[bimdf.g.id(ei.u)];
+            ei.v = nodes[bimdf.g.id(ei.v)];
+            if ((i + j) % 2) {
+                std::swap(ei.u, ei.v);
+                std::swap(ei.u_head, ei.v_head);
+            }
+            if (i == n_copies - 1
+                    && std::holds_alternative<CostFunction::VirtualObjective>(ei.cost_function)) {
+                ei.cost_function = CostFunction::AbsDeviation{.target = 7, .weight = 1.};
+            }
+            copies.add_edge(ei);
+        }
+    }
+    BiMDF_ConnectedComponents cc(copies, {.deduplicate = true, .verbosity = 0});
+    ASSERT_EQ(cc.size(), static_cast<size_t>(n_copies));
+    // the modified copy and one representative of the others
+    size_t n_distinct = 0;
+    for (size_t i = 0; i < cc.size(); ++i) {
+        EXPECT_LE(cc.representative(i), i);
+        n_distinct += cc.representative(i) == i;
+    }
+    EXPECT_EQ(n_distinct, 2u);
+
+    // only the representative evaluates the counted cost function
+    counter->n_evaluations = 0;
+    config.deduplicate_components = true;
+    auto res = solve_bimdf(copies, config);
+    EXPECT_EQ(counter->n_evaluations, n_single);
+    ASSERT_TRUE(copies.is_valid(*res.solution));
+    // the modified triangle is optimal at flow 5
+    EXPECT_DOUBLE_EQ(res.cost, (n_copies - 1) * 2. + 3.);
+    EXPECT_DOUBLE_EQ(copies.cost(*res.solution), res.cost);
+}
+
+TEST_F(ComponentsTest, parallel_components_match_sequential)
+{
+    auto abs = [](double target) {
+        return CostFunction::AbsDeviation{.target = target, .weight = 1.};
+    };
+    // one long directed cycle with a bicycle attached (a single component
+    // with long chains), plus many copies of the fixture
+    BiMDF big;
+    const int n_cycle = 3000;
+    std::vector<BiMDF::Node> cycle;
+    for (int i = 0; i < n_cycle; ++i) {
+        cycle.push_back(big.add_node());
+    }
+    for (int i = 0; i < n_cycle; ++i) {
+        big.add_edge({.u = cycle[i], .v = cycle[(i + 1) % n_cycle], .u_head = false, .v_head = true,
+                      .cost_function = abs(i % 7)});
+    }
+    auto d = big.add_node();
+    big.add_edge({.u = cycle[0], .v = d, .u_head = false, .v_head = false, .cost_function = abs(2)});
+    big.add_edge({.u = d, .v = cycle[0], .u_head = true, .v_head = true, .cost_function = abs(2)});
+    for (int copy = 0; copy < 300; ++copy) {
+        add_copy(big, bimdf);
+    }
+    BiMDF_ConnectedComponents cc_seq(big, {.verbosity = 0});
+    BiMDF_ConnectedComponents cc_par(big, {.threads = 4, .verbosity = 0});
+    ASSERT_EQ(cc_seq.size(), 301u);
+    ASSERT_EQ(cc_par.size(), cc_seq.size());
+    for (size_t i = 0; i < cc_seq.size(); ++i) {
+        EXPECT_EQ(cc_seq.bimdf(i).n_edges(), cc_par.bimdf(i).n_edges());
+    }
+    size_t largest = 0;
+    for (size_t i = 0; i < cc_seq.size(); ++i) {
+        if (cc_seq.bimdf(i).n_edges() > cc_seq.bimdf(largest).n_edges()) {
+            largest = i;
+        }
+    }
+    BiMDF_Simplification simp_seq(cc_seq.bimdf(largest), 0, 1);
+    BiMDF_Simplification simp_par(cc_seq.bimdf(largest), 0, 4);
+    EXPECT_EQ(simp_par.bimdf().n_edges(), 2u); // the long cycle and the bicycle
+    EXPECT_EQ(simp_seq.bimdf().n_edges(), simp_par.bimdf().n_edges());
+    EXPECT_EQ(simp_seq.bimdf().n_nodes(), simp_par.bimdf().n_nodes());
+
+    auto res_seq = solve_bimdf(big, config);
+    config.component_threads = 4;
+    auto res_par = solve_bimdf(big, config);
+    ASSERT_TRUE(big.is_valid(*res_par.solution));
+    EXPECT_DOUBLE_EQ(res_seq.cost, res_par.cost);
+    ASSERT_EQ(res_par.cc_info.size(), res_seq.cc_info.size());
+    for (size_t i = 0; i < res_par.cc_info.size(); ++i) {
+        EXPECT_DOUBLE_EQ(res_par.cc_info[i].matching.cost, res_seq.cc_info[i].matching.cost);
+    }
+}
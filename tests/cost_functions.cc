@@ -0,0 +1,254 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include "test_problems.hh"
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Problems/CostBatch.hh>
+#include <libsatsuma/Problems/CostTable.hh>
+#include <libsatsuma/Problems/HomogeneousCosts.hh>
+#include <libsatsuma/Solvers/BiMDFGuess.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+
+using namespace Satsuma;
+using namespace Satsuma::TestProblems;
+
+class CostTest : public TriangleBicycleTest {};
+
+/// Replace all AbsDeviation costs by CountingAbs objectives
+static std::vector<std::shared_ptr<CountingAbs>> count_evaluations(BiMDF &bimdf)
+{
+    std::vector<std::shared_ptr<CountingAbs>> counters;
+    for (const auto e: bimdf.g.edges()) {
+        const auto target = std::get<CostFunction::AbsDeviation>(bimdf.cost_function[e]).target;
+        counters.push_back(std::make_shared<CountingAbs>(target));
+        bimdf.cost_function[e] = CostFunction::VirtualObjective{.obj_ = counters.back()};
+    }
+    return counters;
+}
+
+static size_t n_evaluations(std::vector<std::shared_ptr<CountingAbs>> const &counters)
+{
+    size_t n = 0;
+    for (const auto &c: counters) {
+        n += c->n_evaluations;
+    }
+    return n;
+}
+
+TEST(CostBatchTest, matches_scalar_evaluation)
+{
+    BiMDF bimdf;
+    auto a = bimdf.add_node();
+    auto b = bimdf.add_node();
+    std::vector<CostFunction::Function> functions = {
+        CostFunction::Zero(),
+        CostFunction::AbsDeviation{.target = 2.5, .weight = 3.},
+        CostFunction::QuadDeviation{.target = 1., .weight = .5},
+        CostFunction::ScaleFactor{.target = 4., .weight = 2.},
+    };
+    functions.push_back(CostFunction::Sum(functions.begin() + 1, functions.end()));
+    auto counter = std::make_shared<CountingAbs>(2.);
+    functions.push_back(CostFunction::VirtualObjective{.obj_ = counter});
+    for (int i = 0; i < 24; ++i) {
+        bimdf.add_edge({.u = a, .v = b, .u_head = false, .v_head = true,
+                        .cost_function = functions[i % functions.size()]});
+    }
+    BiMDF::Solution x{bimdf.g};
+    int i = 0;
+    for (auto e: bimdf.g.edges()) {
+        x[e] = 1 + (i++ % 7);
+    }
+    double scalar = 0.;
+    for (auto e: bimdf.g.edges()) {
+        scalar += CostFunction::cost(bimdf.cost_function[e], x[e]);
+    }
+    CostBatch batch(bimdf);
+    counter->n_evaluations = 0;
+    EXPECT_NEAR(batch.cost(x), scalar, 1e-9);
+    // one evaluation per edge
+    const size_t n_counted = 24 / functions.size();
+    EXPECT_EQ(counter->n_evaluations, n_counted);
+
+    const int radius = 2;
+    std::vector<double> window;
+    counter->n_evaluations = 0;
+    batch.evaluate_window(x, radius, window);
+    EXPECT_EQ(counter->n_evaluations, n_counted * (2 * radius + 1));
+    for (auto e: bimdf.g.edges()) {
+        for (int d = -radius; d <= radius; ++d) {
+            EXPECT_DOUBLE_EQ(window[bimdf.g.id(e) * (2 * radius + 1) + radius + d],
+                             bimdf.cost(e, x[e] + d));
+        }
+    }
+}
+
+TEST_F(CostTest, cost_table)
+{
+    auto counters = count_evaluations(bimdf);
+    const int radius = 3;
+    {
+        CostTable::Scope scope{bimdf, radius};
+        ASSERT_TRUE(bimdf.cost_table);
+        const size_t n_table = n_evaluations(counters);
+        EXPECT_EQ(n_table, bimdf.n_edges() * (2 * radius + 1));
+
+        // the guess, windows around it and its cost are read from the table
+        auto guess = make_guess(bimdf);
+        std::vector<double> window;
+        CostBatch(bimdf).evaluate_window(*guess, radius, window);
+        EXPECT_DOUBLE_EQ(bimdf.cost(*guess), 0.);
+        EXPECT_EQ(n_evaluations(counters), n_table);
+        for (const auto e: bimdf.g.edges()) {
+            for (int d = -radius; d <= radius; ++d) {
+                EXPECT_DOUBLE_EQ(window[bimdf.g.id(e) * (2 * radius + 1) + radius + d], std::abs(d));
+            }
+        }
+
+        // values outside of the window are evaluated
+        const auto e = bimdf.g.edgeFromId(0);
+        EXPECT_DOUBLE_EQ(bimdf.cost(e, (*guess)[e] + radius + 1), radius + 1);
+        EXPECT_EQ(n_evaluations(counters), n_table + 1);
+    }
+    EXPECT_FALSE(bimdf.cost_table);
+
+    // most evaluations of a complete solve are served from the table
+    BiMDF torus;
+    add_torus(torus, 12, 1);
+    auto torus_counters = count_evaluations(torus);
+    auto res = solve_bimdf(torus, config);
+    const size_t n_direct = n_evaluations(torus_counters);
+    for (const auto &c: torus_counters) {
+        c->n_evaluations = 0;
+    }
+    config.cost_table_radius = 4;
+    auto res_table = solve_bimdf(torus, config);
+    EXPECT_DOUBLE_EQ(res.cost, res_table.cost);
+    EXPECT_LT(n_evaluations(torus_counters), n_direct / 2);
+    EXPECT_FALSE(torus.cost_table);
+}
+
+namespace {
+struct ShiftedQuad : CostFunction::BaseObjective {
+    double operator()(double x) const override {return (x - 37.3) * (x - 37.3);}
+    double get_guess() const override {return 0.;}
+};
+} // namespace
+
+TEST(CostFunctionTest, argmin_matches_scan)
+{
+    std::vector<CostFunction::Function> chain;
+    for (int i = 0; i < 50; ++i) {
+        chain.push_back(CostFunction::AbsDeviation{.target = 1000. * (i % 5), .weight = 1. + i % 3});
+    }
+    chain.push_back(CostFunction::ScaleFactor{.target = 2.6, .weight = 1.});
+    std::vector<CostFunction::Function> functions = {
+        CostFunction::AbsDeviation{.target = 2.5, .weight = 3.},
+        CostFunction::QuadDeviation{.target = -3.7, .weight = .5},
+        CostFunction::ScaleFactor{.target = 0.4, .weight = 2.},
+        CostFunction::Sum(chain.begin(), chain.end()),
+        CostFunction::VirtualObjective{.obj_ = std::make_shared<ShiftedQuad>()},
+    };
+    for (const auto &f: functions) {
+        for (auto [lower, upper]: {std::pair{0ll, 5000ll}, std::pair{0ll, 20ll}, std::pair{40ll, 60ll}}) {
+            auto best = lower;
+            for (auto x = lower; x <= upper; ++x) {
+                if (CostFunction::cost(f, x) < CostFunction::cost(f, best)) {
+                    best = x;
+                }
+            }
+            auto x = CostFunction::argmin(f, lower, upper);
+            EXPECT_DOUBLE_EQ(CostFunction::cost(f, x), CostFunction::cost(f, best));
+        }
+    }
+
+    // a wide interval is searched with few evaluations
+    auto counter = std::make_shared<CountingAbs>(1234.);
+    EXPECT_EQ(CostFunction::argmin(CostFunction::VirtualObjective{.obj_ = counter}, 0, 1000000), 1234);
+    EXPECT_LT(counter->n_evaluations, 100u);
+}
+
+namespace {
+/// Counts scalar and batched queries
+struct CountingQuad : CostFunction::BaseObjective {
+    double operator()(double x) const override {++n_scalar; return (x - 3.) * (x - 3.);}
+    double get_guess() const override {return 3.;}
+    void evaluate(std::span<const double> _x, std::span<double> _out) const override {
+        ++n_batch;
+        for (size_t i = 0; i < _x.size(); ++i) {
+            _out[i] = (_x[i] - 3.) * (_x[i] - 3.);
+        }
+    }
+    double marginal(double x) const override {++n_marginal; return 2. * (x - 3.) + 1.;}
+    mutable int n_scalar = 0;
+    mutable int n_batch = 0;
+    mutable int n_marginal = 0;
+};
+} // namespace
+
+TEST(CostFunctionTest, batch_and_marginal_queries)
+{
+    auto obj = std::make_shared<CountingQuad>();
+    BiMDF bimdf;
+    auto a = bimdf.add_node();
+    auto b = bimdf.add_node();
+    auto e = bimdf.add_edge({.u = a, .v = b, .u_head = false, .v_head = true,
+                             .cost_function = CostFunction::VirtualObjective{.obj_ = obj}});
+    BiMDF::Guess x{bimdf.g, 0};
+    std::vector<double> window;
+    CostBatch(bimdf).evaluate_window(x, 2, window);
+    EXPECT_EQ(obj->n_batch, 1);
+    EXPECT_EQ(obj->n_scalar, 0);
+    EXPECT_DOUBLE_EQ(window[bimdf.g.id(e) * 5 + 4], 1.);
+
+    EXPECT_EQ(CostFunction::argmin(bimdf.cost_function[e], -100, 100), 3);
+    EXPECT_GT(obj->n_marginal, 0);
+    EXPECT_EQ(obj->n_scalar, 0);
+}
+
+TEST_F(CostTest, piecewise_linear_matches_sum_of_abs)
+{
+    // |x-2| + 2|x-5|
+    CostFunction::PiecewiseLinear pl({2., 5.}, {-3., -1., 3.}, 6.);
+    std::vector<CostFunction::Function> terms = {
+        CostFunction::AbsDeviation{.target = 2., .weight = 1.},
+        CostFunction::AbsDeviation{.target = 5., .weight = 2.},
+    };
+    CostFunction::Sum sum(terms.begin(), terms.end());
+    for (double x = -3.; x <= 9.; x += .5) {
+        EXPECT_DOUBLE_EQ(pl(x), sum(x));
+    }
+    EXPECT_EQ(CostFunction::argmin(pl, -10, 10), 5);
+    EXPECT_EQ(CostFunction::argmin(pl, 7, 10), 7);
+    EXPECT_THROW(CostFunction::PiecewiseLinear({1., 2.}, {1., 0., 2.}), std::invalid_argument);
+
+    for (auto e: bimdf.g.edges()) {
+        auto target = std::get<CostFunction::AbsDeviation>(bimdf.cost_function[e]).target;
+        bimdf.cost_function[e] = CostFunction::PiecewiseLinear({target}, {-1., 1.});
+    }
+    auto res_pl = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_pl.solution));
+    EXPECT_DOUBLE_EQ(res_pl.cost, 2.);
+}
+
+TEST_F(CostTest, homogeneous_cost_type)
+{
+    auto type_name = [](BiMDF const &b) {
+        return with_homogeneous_cost_type(b, [](auto cost_type) -> std::string {
+            using T = typename decltype(cost_type)::type;
+            if constexpr (std::is_same_v<T, CostFunction::AbsDeviation>) {return "abs";}
+            else if constexpr (std::is_same_v<T, CostFunction::QuadDeviation>) {return "quad";}
+            else {return "generic";}
+        });
+    };
+    auto a = bimdf.g.nodeFromId(0);
+    bimdf.add_edge({.u = a, .v = a, .u_head = false, .v_head = true,
+                    .cost_function = CostFunction::Zero{.guess = 3.}});
+    EXPECT_EQ(type_name(bimdf), "abs");
+    auto guess = make_guess(bimdf);
+    for (auto e: bimdf.g.edges()) {
+        EXPECT_EQ((*guess)[e], CostFunction::argmin(bimdf.cost_function[e], bimdf.lower[e], bimdf.upper[e]));
+    }
+    bimdf.add_edge({.u = a, .v = a, .u_head = false, .v_head = true,
+                    .cost_function = CostFunction::QuadDeviation{.target = 1., .weight = 1.}});
+    EXPECT_EQ(type_name(bimdf), "generic");
+}
@@ -0,0 +1,62 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include "test_problems.hh"
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Problems/CostScaling.hh>
+#include <libsatsuma/Solvers/Matching.hh>
+#include <libsatsuma/Exceptions.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+#include <cstdint>
+#include <limits>
+
+using namespace Satsuma;
+using namespace Satsuma::TestProblems;
+
+class CostScalingSolveTest : public TriangleBicycleTest {};
+
+TEST(CostScalingTest, multiplier)
+{
+    EXPECT_EQ(CostScaling(1e3).multiplier(), CostScaling::default_max_multiplier);
+    EXPECT_EQ(CostScaling(0.).multiplier(), CostScaling::default_max_multiplier);
+    CostScaling large{1e20};
+    const auto m = large.multiplier();
+    EXPECT_LE(m * 1e20, CostScaling::default_limit);
+    EXPECT_GT(2 * m * 1e20, CostScaling::default_limit);
+    EXPECT_EQ(large.unscale(large.scale(1e20)), 1e20);
+    EXPECT_THROW(large.scale(1e30), CostOverflowError);
+    EXPECT_THROW(CostScaling(std::numeric_limits<double>::infinity()), CostOverflowError);
+
+    // blossom-V: scaled weights must fit into int
+    const double int_limit = matching_weight_limit(MatchingSolver::BlossomV);
+    EXPECT_EQ(int_limit, std::numeric_limits<int>::max());
+    CostScaling small{1e6, CostScaling::default_max_multiplier, int_limit};
+    EXPECT_LT(small.multiplier(), CostScaling::default_max_multiplier);
+    EXPECT_LE(std::abs(small.scale(-1e6)), std::numeric_limits<int>::max());
+
+    CostAccumulator sum;
+    sum.add(std::numeric_limits<int64_t>::max(), 2);
+    sum.add(std::numeric_limits<int64_t>::max(), -2);
+    sum.add(-5);
+    EXPECT_EQ(sum.value(), -5);
+    sum.add(std::numeric_limits<int64_t>::max(), 1);
+    EXPECT_EQ(sum.value(), std::numeric_limits<int64_t>::max() - 5);
+    sum.add(10);
+    EXPECT_THROW(sum.value(), CostOverflowError);
+}
+
+TEST_F(CostScalingSolveTest, large_weights)
+{
+    for (const auto e: bimdf.g.edges()) {
+        std::get<CostFunction::AbsDeviation>(bimdf.cost_function[e]).weight = 1e15;
+    }
+    config.low_cyclomatic_fast_path = false;
+    auto res = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res.solution));
+    EXPECT_DOUBLE_EQ(res.cost, 2e15);
+    // same optimum as with unit weights: the triangle at flow 4, the bicycle at 2
+    for (const auto e: bimdf.g.edges()) {
+        const bool triangle = bimdf.u_head[e] != bimdf.v_head[e];
+        EXPECT_EQ((*res.solution)[e], triangle ? 4 : 2);
+    }
+}
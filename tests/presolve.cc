@@ -0,0 +1,74 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include "test_problems.hh"
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Reductions/BiMDF_Presolve.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+
+using namespace Satsuma;
+using namespace Satsuma::TestProblems;
+
+class PresolveTest : public TriangleBicycleTest {};
+
+TEST_F(PresolveTest, presolve)
+{
+    auto abs = [](double target) {
+        return CostFunction::AbsDeviation{.target = target, .weight = 1.};
+    };
+    const auto a = bimdf.g.nodeFromId(0);
+    const auto b = bimdf.g.nodeFromId(1);
+    const auto c = bimdf.g.nodeFromId(2);
+    // parallel to a->b:
+    bimdf.add_edge({.u = b, .v = a, .u_head = true, .v_head = false, .cost_function = abs(1)});
+    // pendant node, forced to zero flow:
+    auto p = bimdf.add_node();
+    bimdf.add_edge({.u = p, .v = b, .u_head = false, .v_head = true, .cost_function = abs(3)});
+    // node with two tails, forced to zero:
+    auto q = bimdf.add_node();
+    bimdf.add_edge({.u = q, .v = a, .u_head = false, .v_head = true, .cost_function = abs(1)});
+    bimdf.add_edge({.u = q, .v = c, .u_head = false, .v_head = true, .cost_function = abs(1)});
+
+    BiMDF_Presolve presolve(bimdf, {.bound_tightenings_per_edge = 0, .verbosity = 0});
+    EXPECT_EQ(presolve.n_merged_edges(), 1u);
+    EXPECT_EQ(presolve.n_fixed_edges(), 3u);
+    EXPECT_EQ(presolve.bimdf().n_nodes(), 4u);
+    EXPECT_EQ(presolve.bimdf().n_edges(), 5u);
+
+    config.presolve = true;
+    auto res_presolved = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_presolved.solution));
+    EXPECT_DOUBLE_EQ(res_presolved.cost, bimdf.cost(*res_presolved.solution));
+    // the fixture with the parallel edge costs 1, the forced-zero edges 3 + 1 + 1
+    EXPECT_DOUBLE_EQ(res_presolved.cost, 1. + 5.);
+
+    // fixed edges are only supported with presolve
+    auto fixed = bimdf.add_edge({.u = c, .v = a, .u_head = false, .v_head = true,
+                                 .cost_function = abs(0), .lower = 1, .upper = 1});
+    auto res_fixed = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_fixed.solution));
+    EXPECT_EQ((*res_fixed.solution)[fixed], 1);
+}
+
+TEST_F(PresolveTest, bound_propagation)
+{
+    const auto e_ab = bimdf.g.edgeFromId(0);
+    bimdf.upper[e_ab] = 2;
+
+    // flow conservation at b limits b->c to the capacity of a->b
+    BiMDF_Presolve presolve(bimdf, {.verbosity = 0});
+    EXPECT_GT(presolve.n_tightened_bounds(), 0u);
+    const auto &pre = presolve.bimdf();
+    size_t n_capped = 0;
+    for (const auto e: pre.g.edges()) {
+        n_capped += pre.upper[e] == 2;
+    }
+    EXPECT_GE(n_capped, 2u);
+
+    config.presolve = true;
+    auto res_presolved = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_presolved.solution));
+    EXPECT_EQ((*res_presolved.solution)[e_ab], 2);
+    // the triangle at its capacity: |2-3| + |2-5| + |2-4|
+    EXPECT_DOUBLE_EQ(res_presolved.cost, 6.);
+}
@@ -0,0 +1,249 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#include "test_problems.hh"
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Solvers/BiMDFCycleCanceling.hh>
+#include <libsatsuma/Solvers/BiMDFLocalSearch.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+
+using namespace Satsuma;
+using namespace Satsuma::TestProblems;
+
+class RefinementTest : public TriangleBicycleTest {};
+
+TEST_F(RefinementTest, cycle_canceling_from_zero)
+{
+    BiMDF::Solution zero{bimdf.g, 0};
+    ASSERT_TRUE(bimdf.is_valid(zero));
+    auto res = refine_with_cycle_canceling(bimdf, zero);
+    ASSERT_TRUE(bimdf.is_valid(*res.sol));
+    EXPECT_DOUBLE_EQ(bimdf.cost(*res.sol), 2.);
+    EXPECT_DOUBLE_EQ(res.cost_change, bimdf.cost(*res.sol) - bimdf.cost(zero));
+}
+
+TEST_F(RefinementTest, cycle_canceling_matches_matching)
+{
+    auto res_matching = solve_bimdf(bimdf, config);
+    config.refinement_method = RefinementMethod::CycleCanceling;
+    auto res_cc = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_cc.solution));
+    EXPECT_DOUBLE_EQ(res_cc.cost, 2.);
+    EXPECT_DOUBLE_EQ(res_matching.cost, res_cc.cost);
+}
+
+TEST_F(RefinementTest, restricted_matching_keeps_inactive_edges)
+{
+    BiMDF::Solution zero{bimdf.g, 0};
+    BiMDF::EdgeMap<bool> active{bimdf.g, false};
+    for (const auto e: bimdf.g.edges()) {
+        // only the triangle, i.e. the directed edges
+        active[e] = bimdf.u_head[e] != bimdf.v_head[e];
+    }
+    auto res = refine_with_matching_restricted(bimdf, zero, active, 2);
+    ASSERT_TRUE(bimdf.is_valid(*res.sol));
+    for (const auto e: bimdf.g.edges()) {
+        if (!active[e]) {
+            EXPECT_EQ((*res.sol)[e], 0);
+        }
+    }
+    EXPECT_LT(res.cost_change, 0.);
+}
+
+TEST_F(RefinementTest, frontier_matches_global)
+{
+    // a second directed triangle, whose zero flow is already optimal
+    auto x = bimdf.add_node();
+    auto y = bimdf.add_node();
+    auto z = bimdf.add_node();
+    auto zero_target = CostFunction::AbsDeviation{.target = 0, .weight = 1.};
+    bimdf.add_edge({.u = x, .v = y, .u_head = false, .v_head = true, .cost_function = zero_target});
+    bimdf.add_edge({.u = y, .v = z, .u_head = false, .v_head = true, .cost_function = zero_target});
+    bimdf.add_edge({.u = z, .v = x, .u_head = false, .v_head = true, .cost_function = zero_target});
+
+    // Starting from zero, a pass with max deviation 1 moves the first triangle
+    // only one unit towards its targets, the next pass is localized to its frontier.
+    BiMDF::Solution zero{bimdf.g, 0};
+    auto global = refine_with_matching(bimdf, zero, 1);
+    ASSERT_LT(global.cost_change, 0.);
+    auto frontier = refinement_frontier(bimdf, zero, *global.sol, 1);
+    for (const auto e: bimdf.g.edges()) {
+        const bool second_triangle = bimdf.g.u(e) == x || bimdf.g.u(e) == y || bimdf.g.u(e) == z;
+        EXPECT_EQ((*frontier)[e], !second_triangle);
+    }
+    auto local = refine_with_matching_restricted(bimdf, *global.sol, *frontier, 1);
+    ASSERT_TRUE(bimdf.is_valid(*local.sol));
+    EXPECT_LT(local.cost_change, 0.);
+    bool changed = false;
+    for (const auto e: bimdf.g.edges()) {
+        changed = changed || (*local.sol)[e] != (*global.sol)[e];
+    }
+    EXPECT_TRUE(changed);
+
+    // double cover is suboptimal on the torus
+    BiMDF torus;
+    add_torus(torus, 5, 1);
+    config.refinement_maxdev_min = 1;
+    auto res_global = solve_bimdf_matching(torus, config);
+    config.refinement_frontier_hops = 1;
+    auto res_frontier = solve_bimdf_matching(torus, config);
+    ASSERT_TRUE(torus.is_valid(*res_frontier.result.solution));
+    EXPECT_LT(res_frontier.result.cost, res_frontier.double_cover_info.cost);
+    EXPECT_DOUBLE_EQ(res_global.result.cost, res_frontier.result.cost);
+}
+
+TEST_F(RefinementTest, regions_match_global)
+{
+    BiMDF torus;
+    add_torus(torus, 6, 1);
+    BiMDF::Solution zero{torus.g, 0};
+    auto regions = bfs_edge_regions(torus, 6, torus.g.nodeFromId(0));
+    ASSERT_GT(regions.size(), 1u);
+    auto sequential = refine_regions_with_matching(torus, zero, regions, 2,
+            DeviationLimitKind::Default, MatchingSolver::Default, 1);
+    auto parallel = refine_regions_with_matching(torus, zero, regions, 2,
+            DeviationLimitKind::Default, MatchingSolver::Default, 4);
+    ASSERT_TRUE(torus.is_valid(*parallel.sol));
+    EXPECT_LT(parallel.cost_change, 0.);
+    EXPECT_DOUBLE_EQ(parallel.cost_change, sequential.cost_change);
+    EXPECT_DOUBLE_EQ(torus.cost(*parallel.sol) - torus.cost(zero), parallel.cost_change);
+    size_t n_improved_regions = 0;
+    for (const auto &region: regions) {
+        bool changed = false;
+        for (const auto e: region) {
+            EXPECT_EQ((*parallel.sol)[e], (*sequential.sol)[e]);
+            changed = changed || (*parallel.sol)[e] != 0;
+        }
+        n_improved_regions += changed;
+    }
+    EXPECT_GT(n_improved_regions, 1u);
+
+    // 144 edges, regions are used while they improve the flow
+    auto res_global = solve_bimdf_matching(torus, config);
+    config.refinement_region_edges = 24;
+    config.refinement_threads = 2;
+    auto res_regions = solve_bimdf_matching(torus, config);
+    ASSERT_TRUE(torus.is_valid(*res_regions.result.solution));
+    EXPECT_LT(res_regions.result.cost, res_regions.double_cover_info.cost);
+    EXPECT_DOUBLE_EQ(res_global.result.cost, res_regions.result.cost);
+}
+
+TEST_F(RefinementTest, certificate)
+{
+    BiMDF::Solution zero{bimdf.g, 0};
+    std::vector<MCF::CostScalar> potential;
+    EXPECT_FALSE(refinement_certificate(bimdf, zero, 2, potential));
+    config.refinement_certificate = false;
+    auto res = solve_bimdf(bimdf, config);
+    EXPECT_TRUE(refinement_certificate(bimdf, *res.solution, 2, potential));
+    config.refinement_certificate = true;
+    auto res_cert = solve_bimdf(bimdf, config);
+    EXPECT_DOUBLE_EQ(res.cost, res_cert.cost);
+}
+
+TEST_F(RefinementTest, reduced_cost_fixing_matches_global)
+{
+    // double cover is suboptimal on this instance
+    BiMDF torus;
+    add_torus(torus, 5, 1);
+    auto dc = approximate_bimdf_doublecover(torus, config.double_cover);
+    auto active = reduced_cost_candidates(torus, *dc.solution, dc.potential, dc.potential_multiplier, 0.5);
+    size_t n_active = 0;
+    for (const auto e: torus.g.edges()) {
+        n_active += (*active)[e];
+    }
+    EXPECT_GT(n_active, 0u);
+    EXPECT_LT(n_active, torus.n_edges());
+    auto res = refine_with_matching_restricted(torus, *dc.solution, *active, 2);
+    ASSERT_TRUE(torus.is_valid(*res.sol));
+    EXPECT_LT(res.cost_change, 0.);
+    for (const auto e: torus.g.edges()) {
+        if (!(*active)[e]) {
+            EXPECT_EQ((*res.sol)[e], (*dc.solution)[e]);
+        }
+    }
+
+    auto res_global = solve_bimdf_matching(torus, config);
+    EXPECT_LT(res_global.result.cost, dc.info.cost);
+    config.refinement_fixing_threshold = 0.5;
+    auto res_fixing = solve_bimdf_matching(torus, config);
+    ASSERT_TRUE(torus.is_valid(*res_fixing.result.solution));
+    EXPECT_DOUBLE_EQ(res_global.result.cost, res_fixing.result.cost);
+}
+
+TEST_F(RefinementTest, deviation_windows)
+{
+    config.refinement_certificate = false;
+    auto res_global = solve_bimdf(bimdf, config);
+    auto windows = deviation_windows(bimdf, *res_global.solution, 2, 0.5);
+    for (const auto e: bimdf.g.edges()) {
+        // AbsDeviation costs with weight 1 are pinned exactly at their target
+        bool at_target = bimdf.cost(e, (*res_global.solution)[e]) == 0.;
+        EXPECT_EQ((*windows)[e] == 0, at_target);
+    }
+    config.refinement_window_pin_cost = 0.5;
+    auto res_windows = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_windows.solution));
+    EXPECT_DOUBLE_EQ(res_global.cost, res_windows.cost);
+
+    // far from the targets, the windows must be wider than one unit
+    BiMDF::Solution zero{bimdf.g, 0};
+    auto wide = deviation_windows(bimdf, zero, 4, 0.5);
+    BiMDF::EdgeMap<int> unit{bimdf.g, 1};
+    bool any_wide = false;
+    for (const auto e: bimdf.g.edges()) {
+        any_wide |= (*wide)[e] > 1;
+    }
+    EXPECT_TRUE(any_wide);
+    auto res_unit = refine_with_matching(bimdf, zero, 4, DeviationLimitKind::Default,
+                                         MatchingSolver::Default, &unit);
+    auto res_wide = refine_with_matching(bimdf, zero, 4, DeviationLimitKind::Default,
+                                         MatchingSolver::Default, wide.get());
+    ASSERT_TRUE(bimdf.is_valid(*res_wide.sol));
+    EXPECT_LT(res_wide.cost_change, res_unit.cost_change);
+}
+
+TEST_F(RefinementTest, memory_budget_limits_maxdev)
+{
+    EXPECT_LT(estimate_refinement_memory(bimdf, 1), estimate_refinement_memory(bimdf, 2));
+    config.refinement_maxdev_min = 1;
+    config.refinement_maxdev_max = 3;
+    config.refinement_adaptive_maxdev = true;
+    auto res_unlimited = solve_bimdf_matching(bimdf, config);
+    EXPECT_EQ(res_unlimited.info.max_deviation, 3);
+
+    config.refinement_memory_budget = estimate_refinement_memory(bimdf, 2);
+    auto res = solve_bimdf_matching(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res.result.solution));
+    EXPECT_DOUBLE_EQ(res.result.cost, 2.);
+    EXPECT_EQ(res.info.max_deviation, 2);
+}
+
+TEST_F(RefinementTest, local_search_from_zero)
+{
+    BiMDF::Solution zero{bimdf.g, 0};
+    auto res = refine_with_local_search(bimdf, zero);
+    ASSERT_TRUE(bimdf.is_valid(*res.sol));
+    // both the triangle and the c-d two-cycle are short cycles
+    EXPECT_DOUBLE_EQ(bimdf.cost(*res.sol), 2.);
+    EXPECT_DOUBLE_EQ(res.cost_change, bimdf.cost(*res.sol) - bimdf.cost(zero));
+}
+
+TEST_F(RefinementTest, local_search_method)
+{
+    config.refinement_method = RefinementMethod::LocalSearch;
+    config.refine_with_matching = false;
+    auto res_preview = solve_bimdf(bimdf, config);
+    ASSERT_TRUE(bimdf.is_valid(*res_preview.solution));
+    ASSERT_EQ(res_preview.cc_info.size(), 1u);
+    const auto &preview = res_preview.cc_info[0].matching;
+    // a single local search, no matching passes
+    EXPECT_EQ(preview.cost_changes.size(), 1u);
+    EXPECT_EQ(preview.max_deviation, 0);
+    EXPECT_DOUBLE_EQ(preview.cost - preview.cost_changes[0], res_preview.cc_info[0].double_cover.cost);
+
+    config.refine_with_matching = true;
+    auto res = solve_bimdf(bimdf, config);
+    EXPECT_EQ(res.cc_info[0].matching.max_deviation, config.refinement_maxdev_max);
+    EXPECT_DOUBLE_EQ(res.cost, 2.);
+}
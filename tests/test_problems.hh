@@ -0,0 +1,92 @@
+//  SPDX-FileCopyrightText: 2023 Martin Heistermann <martin.heistermann@unibe.ch>
+//  SPDX-License-Identifier: MIT
+#pragma once
+
+#include <gtest/gtest.h>
+#include <libsatsuma/Problems/BiMDF.hh>
+#include <libsatsuma/Extra/Highlevel.hh>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace Satsuma::TestProblems {
+
+/// Directed triangle a->b->c->a plus a bidirected "bicycle" c>-<d, d<->c.
+/// Optimal cost 2 (the triangle at flow 4, the bicycle at its targets).
+inline void add_triangle_bicycle(BiMDF &bimdf)
+{
+    auto a = bimdf.add_node();
+    auto b = bimdf.add_node();
+    auto c = bimdf.add_node();
+    auto d = bimdf.add_node();
+    auto abs = [](double target) {
+        return CostFunction::AbsDeviation{.target = target, .weight = 1.};
+    };
+    bimdf.add_edge({.u = a, .v = b, .u_head = false, .v_head = true, .cost_function = abs(3)});
+    bimdf.add_edge({.u = b, .v = c, .u_head = false, .v_head = true, .cost_function = abs(5)});
+    bimdf.add_edge({.u = c, .v = a, .u_head = false, .v_head = true, .cost_function = abs(4)});
+    bimdf.add_edge({.u = c, .v = d, .u_head = false, .v_head = false, .cost_function = abs(2)});
+    bimdf.add_edge({.u = d, .v = c, .u_head = true, .v_head = true, .cost_function = abs(2)});
+}
+
+/// n x n torus grid with a pair of opposite directed edges per grid edge and
+/// pseudo-random targets: many short cycles, zero flow is far from optimal.
+inline void add_torus(BiMDF &bimdf, int n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> target(0, 4);
+    std::vector<BiMDF::Node> nodes;
+    for (int i = 0; i < n * n; ++i) {
+        nodes.push_back(bimdf.add_node());
+    }
+    auto add = [&](BiMDF::Node u, BiMDF::Node v) {
+        bimdf.add_edge({.u = u, .v = v, .u_head = false, .v_head = true,
+                        .cost_function = CostFunction::AbsDeviation{.target = double(target(rng)), .weight = 1.}});
+    };
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const auto u = nodes[i * n + j];
+            for (const auto v: {nodes[i * n + (j + 1) % n], nodes[((i + 1) % n) * n + j]}) {
+                add(u, v);
+                add(v, u);
+            }
+        }
+    }
+}
+
+/// Add a copy of `_src` as separate component(s) of `_dst`.
+inline void add_copy(BiMDF &_dst, BiMDF const &_src)
+{
+    BiMDF::NodeMap<BiMDF::Node> nodes(_src.g);
+    for (const auto n: _src.g.nodes()) {
+        nodes[n] = _dst.add_node(_src.demand[n]);
+    }
+    for (const auto e: _src.g.edges()) {
+        auto ei = _src.get_edge_info(e);
+        ei.u = nodes[ei.u];
+        ei.v = nodes[ei.v];
+        _dst.add_edge(ei);
+    }
+}
+
+/// |x - target| that counts its evaluations
+struct CountingAbs : CostFunction::BaseObjective {
+    explicit CountingAbs(double _target) : target(_target) {}
+    double operator()(double x) const override {++n_evaluations; return std::fabs(x - target);}
+    double get_guess() const override {return target;}
+    double target;
+    mutable size_t n_evaluations = 0;
+};
+
+class TriangleBicycleTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        config.verbosity = 0;
+        config.double_cover.verbosity = 0;
+        add_triangle_bicycle(bimdf);
+    }
+    BiMDF bimdf;
+    BiMDFSolverConfig config;
+};
+
+} // namespace Satsuma::TestProblems
@@ -16,9 +16,8 @@ int main(int argc, char *argv[])
     using BiMDF = Satsuma::BiMDF;
     auto bimdf = Satsuma::read_bimdf(argv[1]);
 
-    auto config = Satsuma::BiMDFSolverConfig {
-        .matching_solver = Satsuma::MatchingSolver::Lemon
-    };
+    Satsuma::BiMDFSolverConfig config;
+    config.matching_solver = Satsuma::MatchingSolver::Lemon;
     auto result = Satsuma::solve_bimdf(*bimdf, config);
     std::cout << "Total cost: " << result.cost << std::endl;
 
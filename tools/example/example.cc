@@ -46,10 +46,9 @@ int main(int argc, char *argv[])
             .cost_function = Abs{.target=.2, .weight = 1},
             .lower=0});
 
-    auto config = Satsuma::BiMDFSolverConfig {
-        //.matching_solver = Satsuma::MatchingSolver::BlossomV
-        .matching_solver = Satsuma::MatchingSolver::Lemon
-    };
+    Satsuma::BiMDFSolverConfig config;
+    //config.matching_solver = Satsuma::MatchingSolver::BlossomV;
+    config.matching_solver = Satsuma::MatchingSolver::Lemon;
     auto result = Satsuma::solve_bimdf(bimdf, config);
     std::cout << "Total cost: " << result.cost << std::endl;
     for (const auto& [name, edge]: edges) {
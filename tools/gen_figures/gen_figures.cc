@@ -122,7 +122,7 @@ int main(int argc, char *argv[])
     BiMDF::Guess rounded_target{bimdf.g};
     for (const auto &e: bimdf.g.edges()) {
         auto target = CostFunction::get_guess(bimdf.cost_function[e]);
-        auto rounded = static_cast<int>(std::lround(target));
+        auto rounded = static_cast<BiMDF::FlowScalar>(std::lround(target));
         rounded_target[e] = std::max(bimdf.lower[e], rounded);
     }
 